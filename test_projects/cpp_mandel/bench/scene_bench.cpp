@@ -0,0 +1,346 @@
+// Regression benchmark over a fixed catalogue of scenes. Times each compute
+// engine, kernel and schedule on every scene, and each writer on one grid,
+// with warmup runs and repetitions, and prints the median, p95 and minimum
+// as JSON for comparison between releases (human-readable lines go to
+// stderr). Schedules also report the idle time of the threads, from one
+// extra traced run.
+//
+//   mandel_bench [--size N] [--reps R] [--warmup W] [--threads T]
+//                [--filter TEXT] [--out PATH] [--scratch PATH]
+//
+// --filter keeps the measurements whose name (e.g. kernel/avx2/seahorse)
+// contains TEXT; --scratch is the file the writers write to.
+#include "mandel/core.hpp"
+#include "mandel/kernels.hpp"
+#include "mandel/parallel.hpp"
+#include "mandel/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct Scene {
+  const char *name;
+  double center_x;
+  double center_y;
+  double span; // plane width of the view, whatever the pixel size
+  int max_iters;
+};
+
+// Full set; slow escapes around a spiral; the inside of the main cardioid
+// only; fast escapes only; and a boundary deep enough that most pixels run
+// thousands of iterations, still within double precision.
+constexpr Scene kScenes[] = {
+    {"full", -0.75, 0.0, 3.0, 256},
+    {"seahorse", -0.745, 0.113, 0.002, 2000},
+    {"interior", -0.2, 0.0, 0.2, 1000},
+    {"exterior", 1.0, 1.0, 0.5, 1000},
+    {"deep", -0.743643887037151, 0.131825904205330, 2e-9, 10000},
+};
+
+struct Options {
+  int size = 256;
+  int reps = 5;
+  int warmup = 1;
+  int threads = 1;
+  std::string filter;
+  std::string out;
+  std::string scratch = "mandel_bench.tmp";
+};
+
+struct Timing {
+  double median;
+  double p95;
+  double min;
+};
+
+// Time each pool participant spent outside tiles during one run.
+struct Idle {
+  double mean_s;
+  double max_s;
+  double fraction; // of threads x wall time
+};
+
+// Nearest-rank percentiles over `reps` runs, after `warmup` untimed ones.
+Timing measure(const Options &o, const std::function<void()> &fn) {
+  for (int i = 0; i < o.warmup; ++i)
+    fn();
+  std::vector<double> t;
+  for (int i = 0; i < o.reps; ++i) {
+    const auto t0 = std::chrono::steady_clock::now();
+    fn();
+    t.push_back(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0)
+                    .count());
+  }
+  std::sort(t.begin(), t.end());
+  const auto rank = [&](double q) {
+    const auto k = static_cast<std::size_t>(
+        std::ceil(q * static_cast<double>(t.size())));
+    return t[std::max<std::size_t>(k, 1) - 1];
+  };
+  return {rank(0.5), rank(0.95), t.front()};
+}
+
+// One compute_grid() on a traced pool of the same size as pool.
+Idle measure_idle(const mandel::Params &p, const mandel::ThreadPool &pool,
+                  mandel::GridResult &grid) {
+  mandel::Tracer tracer;
+  double wall = 0.0;
+  {
+    mandel::ThreadPool traced(pool.size(), &tracer);
+    const auto t0 = std::chrono::steady_clock::now();
+    mandel::compute_grid(p, grid, traced);
+    wall = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         t0)
+               .count();
+  }
+  Idle idle{0.0, 0.0, 0.0};
+  for (int w = 0; w < pool.size(); ++w) {
+    const double busy =
+        static_cast<double>(tracer.total(mandel::TraceKind::tile, w)) * 1e-9;
+    const double gap = std::max(wall - busy, 0.0);
+    idle.mean_s += gap / pool.size();
+    idle.max_s = std::max(idle.max_s, gap);
+  }
+  idle.fraction = wall > 0.0 ? idle.mean_s / wall : 0.0;
+  return idle;
+}
+
+mandel::Params scene_params(const Scene &s, const Options &o) {
+  mandel::Params p;
+  p.width = o.size;
+  p.height = o.size;
+  p.center_x = s.center_x;
+  p.center_y = s.center_y;
+  p.scale = s.span / o.size;
+  p.max_iters = s.max_iters;
+  p.threads = o.threads;
+  return p;
+}
+
+std::uint64_t total_iterations(mandel::Params p, mandel::ThreadPool &pool) {
+  p.channels = {mandel::Channel::x, mandel::Channel::y,
+                mandel::Channel::iterations};
+  mandel::GridResult g;
+  mandel::compute_grid(p, g, pool);
+  std::uint64_t n = 0;
+  for (std::size_t i = 0; i < g.size(); ++i)
+    n += g.iterations()[i];
+  return n;
+}
+
+// Accumulates the JSON report; names and groups never need escaping.
+class Report {
+public:
+  explicit Report(const Options &o) : o_(o) {}
+
+  void scene(const Scene &s, const mandel::Params &p,
+             std::uint64_t iterations) {
+    add(scenes_, "    {\"name\": \"" + std::string(s.name) +
+                     "\", \"center_x\": " + num(p.center_x, 17) +
+                     ", \"center_y\": " + num(p.center_y, 17) +
+                     ", \"scale\": " + num(p.scale, 17) +
+                     ", \"max_iters\": " + std::to_string(p.max_iters) +
+                     ", \"iterations\": " + std::to_string(iterations) + "}");
+  }
+
+  // bytes > 0 for writers, iterations > 0 for computations, idle for
+  // schedules.
+  void result(const std::string &group, const std::string &variant,
+              const std::string &scene, const Timing &t, double pixels,
+              std::uint64_t iterations, std::uint64_t bytes,
+              const Idle *idle = nullptr) {
+    const std::string name = group + "/" + variant + "/" + scene;
+    std::string r = "    {\"name\": \"" + name + "\", \"group\": \"" + group +
+                    "\", \"variant\": \"" + variant + "\", \"scene\": \"" +
+                    scene + "\", \"median_s\": " + num(t.median) +
+                    ", \"p95_s\": " + num(t.p95) +
+                    ", \"min_s\": " + num(t.min) +
+                    ", \"pixels_per_s\": " + num(pixels / t.median);
+    if (iterations > 0)
+      r += ", \"iterations_per_s\": " +
+           num(static_cast<double>(iterations) / t.median);
+    if (bytes > 0)
+      r += ", \"bytes\": " + std::to_string(bytes) + ", \"mb_per_s\": " +
+           num(static_cast<double>(bytes) / 1e6 / t.median);
+    if (idle)
+      r += ", \"idle_mean_s\": " + num(idle->mean_s) +
+           ", \"idle_max_s\": " + num(idle->max_s) +
+           ", \"idle_fraction\": " + num(idle->fraction);
+    add(results_, r + "}");
+    std::fprintf(stderr, "%-28s median %9.4f s  p95 %9.4f s  %12.0f px/s",
+                 name.c_str(), t.median, t.p95, pixels / t.median);
+    if (idle)
+      std::fprintf(stderr, "  idle %5.1f%%", 100.0 * idle->fraction);
+    std::fputc('\n', stderr);
+  }
+
+  std::string json() const {
+    return "{\n  \"benchmark\": \"mandel_bench\",\n  \"schema\": 1,\n"
+           "  \"size\": " +
+           std::to_string(o_.size) +
+           ",\n  \"reps\": " + std::to_string(o_.reps) +
+           ",\n  \"warmup\": " + std::to_string(o_.warmup) +
+           ",\n  \"threads\": " +
+           std::to_string(mandel::resolve_threads(o_.threads)) +
+           ",\n  \"kernel\": \"" +
+           mandel::kernel_name(
+               mandel::resolve_kernel(mandel::Kernel::automatic)) +
+           "\",\n  \"scenes\": [\n" + scenes_ + "\n  ],\n  \"results\": [\n" +
+           results_ + "\n  ]\n}\n";
+  }
+
+private:
+  static std::string num(double v, int digits = 9) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.*g", digits, v);
+    return buf;
+  }
+  static void add(std::string &list, const std::string &item) {
+    if (!list.empty())
+      list += ",\n";
+    list += item;
+  }
+
+  const Options &o_;
+  std::string scenes_;
+  std::string results_;
+};
+
+bool parse_args(int argc, char **argv, Options &o) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view flag(argv[i]);
+    if (i + 1 >= argc)
+      return false;
+    const char *v = argv[++i];
+    if (flag == "--size")
+      o.size = std::atoi(v);
+    else if (flag == "--reps")
+      o.reps = std::atoi(v);
+    else if (flag == "--warmup")
+      o.warmup = std::atoi(v);
+    else if (flag == "--threads")
+      o.threads = std::atoi(v);
+    else if (flag == "--filter")
+      o.filter = v;
+    else if (flag == "--out")
+      o.out = v;
+    else if (flag == "--scratch")
+      o.scratch = v;
+    else
+      return false;
+  }
+  return o.size > 0 && o.reps > 0 && o.warmup >= 0 && o.threads >= 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options o;
+  if (!parse_args(argc, argv, o)) {
+    std::fprintf(stderr,
+                 "usage: %s [--size N] [--reps R] [--warmup W] [--threads T]\n"
+                 "          [--filter TEXT] [--out PATH] [--scratch PATH]\n",
+                 argv[0]);
+    return 2;
+  }
+  auto wanted = [&](const std::string &name) {
+    return o.filter.empty() || name.find(o.filter) != std::string::npos;
+  };
+
+  mandel::ThreadPool pool(mandel::resolve_threads(o.threads));
+  Report report(o);
+  const double pixels = static_cast<double>(o.size) * o.size;
+  mandel::GridResult grid;
+  for (const Scene &s : kScenes) {
+    const mandel::Params base = scene_params(s, o);
+    const std::uint64_t iterations = total_iterations(base, pool);
+    report.scene(s, base, iterations);
+
+    for (mandel::Engine e :
+         {mandel::Engine::grid, mandel::Engine::subdivide,
+          mandel::Engine::perturbation}) {
+      const std::string variant = mandel::engine_name(e);
+      if (!wanted("engine/" + variant + "/" + s.name))
+        continue;
+      mandel::Params p = base;
+      p.engine = e;
+      report.result("engine", variant, s.name,
+                    measure(o, [&] { mandel::compute_grid(p, grid, pool); }),
+                    pixels, iterations, 0);
+    }
+    for (mandel::Kernel k : {mandel::Kernel::scalar, mandel::Kernel::avx2,
+                             mandel::Kernel::avx512}) {
+      const std::string variant = mandel::kernel_name(k);
+      if (!mandel::kernel_supported(k) ||
+          !wanted("kernel/" + variant + "/" + s.name))
+        continue;
+      mandel::Params p = base;
+      p.kernel = k;
+      report.result("kernel", variant, s.name,
+                    measure(o, [&] { mandel::compute_grid(p, grid, pool); }),
+                    pixels, iterations, 0);
+    }
+    for (mandel::Schedule sc : {mandel::Schedule::rows, mandel::Schedule::steal,
+                                mandel::Schedule::cost}) {
+      const std::string variant = mandel::schedule_name(sc);
+      if (!wanted("schedule/" + variant + "/" + s.name))
+        continue;
+      mandel::Params p = base;
+      p.schedule = sc;
+      const Timing t =
+          measure(o, [&] { mandel::compute_grid(p, grid, pool); });
+      const Idle idle = measure_idle(p, pool, grid);
+      report.result("schedule", variant, s.name, t, pixels, iterations, 0,
+                    &idle);
+    }
+  }
+
+  // Writers, on the full set with every channel.
+  mandel::Params p = scene_params(kScenes[0], o);
+  p.channels = {mandel::Channel::x, mandel::Channel::y,
+                mandel::Channel::iterations, mandel::Channel::escaped,
+                mandel::Channel::smooth};
+  mandel::compute_grid(p, grid, pool);
+  for (mandel::OutputFormat f :
+       {mandel::OutputFormat::csv, mandel::OutputFormat::npy,
+        mandel::OutputFormat::raw}) {
+    const std::string variant = mandel::format_name(f);
+    if (!wanted("writer/" + variant + "/" + kScenes[0].name))
+      continue;
+    const Timing t = measure(o, [&] {
+      auto w = mandel::make_writer(f, o.scratch);
+      mandel::write_grid(*w, p, grid);
+    });
+    std::uint64_t bytes = std::filesystem::file_size(o.scratch);
+    if (f == mandel::OutputFormat::raw) {
+      bytes += std::filesystem::file_size(o.scratch + ".json");
+      std::remove((o.scratch + ".json").c_str());
+    }
+    std::remove(o.scratch.c_str());
+    report.result("writer", variant, kScenes[0].name, t, pixels, 0, bytes);
+  }
+
+  const std::string json = report.json();
+  if (o.out.empty()) {
+    std::fputs(json.c_str(), stdout);
+    return 0;
+  }
+  std::FILE *f = std::fopen(o.out.c_str(), "wb");
+  if (!f || std::fputs(json.c_str(), f) < 0 || std::fclose(f) != 0) {
+    std::fprintf(stderr, "failed to write %s\n", o.out.c_str());
+    return 1;
+  }
+  return 0;
+}
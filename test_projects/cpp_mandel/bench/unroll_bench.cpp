@@ -0,0 +1,91 @@
+// Pixels/sec of the scalar escape kernel for each unroll factor (--unroll),
+// on the same pixel queue: every pixel of a size x size view (seahorse
+// valley by default, mostly slow escapes; --full for the whole set).
+//
+//   mandel_bench_unroll [--size N] [--reps R] [--max-iters N] [--full]
+#include "mandel/kernels.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+double median_seconds(int reps, mandel::BatchKernelFn fn,
+                      const mandel::PixelBatch &b) {
+  std::vector<double> t;
+  for (int i = 0; i < reps; ++i) {
+    const auto t0 = std::chrono::steady_clock::now();
+    fn(b);
+    t.push_back(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0)
+                    .count());
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int size = 256;
+  int reps = 5;
+  int max_iters = 2000;
+  bool full = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view flag(argv[i]);
+    if (flag == "--full")
+      full = true;
+    else if (i + 1 < argc && flag == "--size")
+      size = std::atoi(argv[++i]);
+    else if (i + 1 < argc && flag == "--reps")
+      reps = std::atoi(argv[++i]);
+    else if (i + 1 < argc && flag == "--max-iters")
+      max_iters = std::atoi(argv[++i]);
+  }
+  if (size <= 0 || reps <= 0 || max_iters <= 0) {
+    std::fprintf(stderr,
+                 "usage: %s [--size N] [--reps R] [--max-iters N] [--full]\n",
+                 argv[0]);
+    return 2;
+  }
+
+  mandel::Params p;
+  p.width = size;
+  p.height = size;
+  p.max_iters = max_iters;
+  if (full) {
+    p.scale = 3.0 / size;
+  } else {
+    p.center_x = -0.745;
+    p.center_y = 0.113;
+    p.scale = 0.002 / size;
+  }
+  std::vector<double> cx, cy;
+  for (int py = 0; py < p.height; ++py) {
+    for (int px = 0; px < p.width; ++px) {
+      auto [x, y] = mandel::map_pixel_to_plane(p, px, py);
+      cx.push_back(x);
+      cy.push_back(y);
+    }
+  }
+  std::vector<double> zx(cx.size()), zy(cx.size());
+  const mandel::PixelBatch b{cx.data(), cy.data(), cx.size(),
+                             p.max_iters, zx.data(), zy.data()};
+
+  const double pixels = static_cast<double>(cx.size());
+  double base = 0.0;
+  std::printf("%s, %d x %d, max-iters %d\n", full ? "full set" : "seahorse",
+              size, size, max_iters);
+  for (int k : {1, 2, 4, 8, 16}) {
+    const double s = median_seconds(reps, mandel::unrolled_kernel_fn(k), b);
+    if (k == 1)
+      base = s;
+    std::printf("unroll %-2d  %8.3f s  %12.0f pixels/s  (%.2fx)\n", k, s,
+                pixels / s, base / s);
+  }
+  return 0;
+}
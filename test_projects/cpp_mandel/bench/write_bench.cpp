@@ -0,0 +1,95 @@
+// Rows/sec of mandel::write_csv against the std::ofstream operator<< writer
+// it replaced, and of the npy writer. All write the same grid (computed
+// once, default view) to the same scratch file.
+//
+//   mandel_bench_write [--size N] [--reps R] [--out PATH]
+#include "mandel/core.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// The writer as it was before std::to_chars (6 significant digits).
+void write_csv_ostream(const std::string &path,
+                       const mandel::GridResult &data) {
+  std::ofstream ofs(path, std::ios::out | std::ios::trunc);
+  if (!ofs)
+    throw std::runtime_error("Failed to open CSV for writing: " + path);
+  ofs << "px,py,x,y\n";
+  for (const auto &r : data)
+    ofs << r.px << ',' << r.py << ',' << r.x << ',' << r.y << '\n';
+  if (!ofs)
+    throw std::runtime_error("I/O error while writing CSV: " + path);
+}
+
+double median_seconds(int reps, const std::function<void()> &fn) {
+  std::vector<double> t;
+  for (int i = 0; i < reps; ++i) {
+    const auto t0 = std::chrono::steady_clock::now();
+    fn();
+    t.push_back(std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0)
+                    .count());
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int size = 1024;
+  int reps = 5;
+  std::string out = "mandel_bench_write.csv";
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string_view flag(argv[i]);
+    if (flag == "--size")
+      size = std::atoi(argv[i + 1]);
+    else if (flag == "--reps")
+      reps = std::atoi(argv[i + 1]);
+    else if (flag == "--out")
+      out = argv[i + 1];
+  }
+  if (size <= 0 || reps <= 0) {
+    std::fprintf(stderr, "usage: %s [--size N] [--reps R] [--out PATH]\n",
+                 argv[0]);
+    return 2;
+  }
+
+  mandel::Params p;
+  p.width = size;
+  p.height = size;
+  p.scale = 3.0 / size;
+  p.threads = 0;
+  mandel::GridResult data;
+  mandel::compute_grid(p, data);
+
+  const double rows = static_cast<double>(data.size());
+  const double before =
+      median_seconds(reps, [&] { write_csv_ostream(out, data); });
+  const double after =
+      median_seconds(reps, [&] { mandel::write_csv(out, data); });
+  const double npy = median_seconds(reps, [&] {
+    auto w = mandel::make_writer(mandel::OutputFormat::npy, out);
+    mandel::write_grid(*w, p, data);
+  });
+  std::remove(out.c_str());
+
+  std::printf("rows            %.0f\n", rows);
+  std::printf("ostream writer  %8.3f s  %12.0f rows/s\n", before,
+              rows / before);
+  std::printf("write_csv       %8.3f s  %12.0f rows/s  (%.1fx)\n", after,
+              rows / after, before / after);
+  std::printf("npy writer      %8.3f s  %12.0f rows/s  (%.1fx)\n", npy,
+              rows / npy, before / npy);
+  return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace mandel {
+
+// Cache-line alignment: a full AVX-512 vector, and no false sharing between
+// buffers owned by different threads.
+inline constexpr std::size_t kCacheLine = 64;
+
+// std::allocator with Align-byte aligned storage, so the first element of
+// every buffer can be read with aligned vector loads.
+template <class T, std::size_t Align = kCacheLine> struct AlignedAllocator {
+  using value_type = T;
+  template <class U> struct rebind {
+    using other = AlignedAllocator<U, Align>;
+  };
+
+  AlignedAllocator() = default;
+  template <class U>
+  AlignedAllocator(const AlignedAllocator<U, Align> &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t{Align}));
+  }
+  void deallocate(T *ptr, std::size_t) noexcept {
+    ::operator delete(ptr, std::align_val_t{Align});
+  }
+
+  template <class U>
+  bool operator==(const AlignedAllocator<U, Align> &) const noexcept {
+    return true;
+  }
+};
+
+template <class T> using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+} // namespace mandel
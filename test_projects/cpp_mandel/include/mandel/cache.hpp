@@ -0,0 +1,51 @@
+#pragma once
+#include "mandel/core.hpp"
+#include <cstdint>
+#include <string>
+
+namespace mandel {
+
+// Canonical text of everything that determines the bytes of an output file:
+// the view, the iteration and approximation settings, the resolved
+// precision, the channels and the file layout. Settings that never change
+// the output (threads, kernel, unroll, symmetry) are left out, so runs that
+// differ only in them share a cache entry.
+std::string cache_key(const Params &p, OutputFormat format,
+                      const WriterOptions &opts);
+
+// 64-bit FNV-1a.
+std::uint64_t fnv1a64(const std::string &s);
+
+// Content-addressed store of output files under one directory, shared by
+// concurrent processes. Each entry is a directory named after the hash of
+// its key, holding the key text, the output and (raw) its sidecar. Entries
+// are assembled in a private temporary directory and renamed into place,
+// so readers only ever see complete entries. A hit refreshes the entry's
+// modification time; once the entries exceed max_bytes the least recently
+// used ones are removed.
+class ResultCache {
+public:
+  ResultCache(std::string dir, std::uint64_t max_bytes);
+
+  // Hardlinks (or, across file systems, copies) the entry for key to path,
+  // plus path.json when the entry has a sidecar. Returns false on a miss,
+  // including entries that vanish or fail to link while being fetched.
+  bool fetch(const std::string &key, const std::string &path) const;
+
+  // Copies path (and path.json if sidecar) into a new entry for key, then
+  // evicts entries beyond max_bytes. An entry stored concurrently by
+  // another process wins. Throws std::runtime_error on I/O errors.
+  void store(const std::string &key, const std::string &path,
+             bool sidecar) const;
+
+  // Total size in bytes of the complete entries.
+  std::uint64_t size() const;
+
+private:
+  void evict() const;
+
+  std::string dir_;
+  std::uint64_t max_bytes_;
+};
+
+} // namespace mandel
@@ -1,10 +1,105 @@
 #pragma once
+#include "mandel/aligned.hpp"
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 namespace mandel {
 
+class ThreadPool;
+
+// Escape-time kernel used by compute_grid. All kernels return bit-identical
+// results; they differ only in speed. `automatic` picks the widest one the
+// CPU supports at runtime.
+enum class Kernel { automatic, scalar, avx2, avx512 };
+
+// Treatment of points inside the main cardioid or the period-2 bulb, whose
+// orbits never escape and would otherwise always cost max_iters iterations.
+enum class Interior {
+  iterate,  // no membership test: every point runs the escape loop
+  exact,    // membership test; interior points iterate to max_iters without
+            // bailout checks. Bit-identical to `iterate`.
+  attractor // membership test; interior points return the attracting fixed
+            // point (cardioid) or 2-cycle point (bulb) that z converges to.
+            // O(1) per point, but only approximates z at max_iters.
+};
+
+// How compute_grid visits the pixels.
+enum class Engine {
+  grid,     // every pixel, in 64x8 tiles
+  subdivide,   // Mariani-Silver: 64x64 blocks are split recursively, and
+               // rectangles whose border never escapes are filled (see Fill)
+  perturbation // deep zoom: one double-double reference orbit at the
+               // center, every pixel iterated as a double delta from it.
+               // Kernel, Interior and cycle_tol do not apply.
+};
+
+// Scalar type of the escape loop for Engine::grid (see precision.hpp).
+// Results are converted to double for output either way.
+enum class Precision {
+  automatic, // cheapest type that resolves the pixel spacing at p.scale
+  f32,       // float: twice the SIMD lanes, for previews down to ~1e-4
+  f64,       // double, to ~1e-13
+  dd,        // double-double (software), to ~1e-29
+  qd         // quad-double (software), to ~1e-60
+};
+
+// How Engine::subdivide fills a rectangle whose border never escapes.
+enum class Fill {
+  exact,      // iterate each inside pixel without bailout checks, then redo
+              // any that escaped after all. Identical to Engine::grid.
+  approximate // copy z from the nearest border pixel: no iterations, but
+              // only membership is meaningful, and exterior filaments
+              // thinner than a pixel can be filled over.
+};
+
+// How compute_grid spreads the tiles over the threads. Output is identical
+// for every schedule.
+enum class Schedule {
+  rows,  // static split: each thread computes one contiguous block of rows,
+         // which idle threads never take over
+  steal, // tiles in row-major order, idle threads steal from busy ones
+  cost   // a pre-pass at 1/16 of the pixels estimates the iterations of
+         // each tile; Engine::grid tiles above their share of the total are
+         // split, and the costliest are dealt first. Incremental recomputes
+         // (compute_grid_incremental) use steal instead.
+};
+
+// Per-pixel output channels.
+enum class Channel {
+  x,          // real(z_final), float64
+  y,          // imag(z_final), float64
+  iterations, // iterations run, uint32 (max_iters if z never escaped)
+  escaped,    // 1 if |z| > 2 was reached, else 0; uint8
+  smooth      // continuous iteration count, float64: n + 1 - log2(ln |z|)
+              // for escaped pixels, max_iters for the others
+};
+
+inline bool has_channel(const std::vector<Channel> &channels, Channel c) {
+  for (Channel have : channels)
+    if (have == c)
+      return true;
+  return false;
+}
+
+// What compute_grid reports about each tile it computed (see
+// Params::on_tile). Pixels are [x0, x1) x [y0, y1).
+struct TileReport {
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+  // Iterations every pixel of the tile skipped through the series
+  // approximation (Engine::perturbation); 0 otherwise.
+  int series_skipped;
+};
+
 struct Params {
   int width = 200;
   int height = 100;
@@ -12,6 +107,44 @@ struct Params {
   double center_y = 0.0;
   double scale = 0.003; // pixel-to-plane scale (smaller = more zoom)
   int max_iters = 200;
+  int threads = 1; // worker threads for compute_grid (<= 0: all cores)
+  Schedule schedule = Schedule::steal;
+  Kernel kernel = Kernel::automatic;
+  // Kernel::scalar only: iterations per block between bailout tests (1, 2,
+  // 4, 8 or 16); see unrolled_kernel(). Output is identical for any value.
+  int unroll = 1;
+  Interior interior = Interior::exact;
+  // Brent periodicity checking for orbits that settle into a cycle:
+  // < 0 disables it; 0 stops only on a bit-exact repeat of z, which keeps
+  // results identical; > 0 accepts |dx|, |dy| <= cycle_tol (approximate).
+  double cycle_tol = -1.0;
+  // Rows whose c values are the exact conjugates of an earlier row's (e.g.
+  // rows py and height - py when center_y = 0) are mirrored instead of
+  // computed. Bit-exact; has no effect when no such rows exist.
+  bool symmetry = true;
+  Engine engine = Engine::grid;
+  Fill fill = Fill::exact; // Engine::subdivide only
+  // Engine::grid only. cycle_tol applies to f64 alone; f32 skips bailout
+  // tests for cardioid/bulb points unless Interior::iterate; dd and qd
+  // run every pixel through the plain escape loop.
+  Precision precision = Precision::f64;
+  // Decimal text of the center for Engine::perturbation and the dd / qd
+  // precisions, which parse it at full precision instead of relying on
+  // center_x / center_y. Empty: use the doubles.
+  std::string center_x_text;
+  std::string center_y_text;
+  // Engine::perturbation series approximation: polynomial order in dc
+  // (0 disables it), and the largest allowed ratio of the first dropped
+  // term to the linear term. Pixels skip the iterations for which the
+  // series meets that tolerance over their whole tile.
+  int series_order = 0;
+  double series_tol = 1e-12;
+  // Instrumentation: called once per computed tile, from worker threads
+  // and possibly concurrently. Empty: no reports.
+  std::function<void(const TileReport &)> on_tile;
+  // Output channels, in file column order. x and y are always computed;
+  // iterations, escaped and smooth only when listed.
+  std::vector<Channel> channels = {Channel::x, Channel::y};
 };
 
 struct PixelResult {
@@ -22,16 +155,207 @@ struct PixelResult {
   double y; // imag(z_final)
 };
 
+// Read-only structure-of-arrays view of image rows [y0, y0 + rows): pixel
+// (px, py) has final z = (x[i], y[i]) with i = (py - y0) * width + px.
+// Iterating it yields PixelResult values, with px/py derived from i.
+struct GridView {
+  const double *x = nullptr;
+  const double *y = nullptr;
+  int width = 0;
+  int y0 = 0; // image row of the first row
+  int rows = 0;
+  // Extra channels, same indexing; null unless computed.
+  const std::uint32_t *iterations = nullptr;
+  const std::uint8_t *escaped = nullptr;
+  const double *smooth = nullptr;
+
+  std::size_t size() const {
+    return static_cast<std::size_t>(width) * static_cast<std::size_t>(rows);
+  }
+  PixelResult operator[](std::size_t i) const {
+    const auto w = static_cast<std::size_t>(width);
+    return {static_cast<int>(i % w), y0 + static_cast<int>(i / w), x[i],
+            y[i]};
+  }
+
+  // Random-access iterator over PixelResult values (dereferences to a
+  // temporary, not a reference).
+  class const_iterator {
+  public:
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = PixelResult;
+    using difference_type = std::ptrdiff_t;
+    using reference = PixelResult;
+
+    const_iterator() = default;
+    const_iterator(const GridView &v, std::size_t i)
+        : x_(v.x), y_(v.y), width_(v.width), y0_(v.y0), i_(i) {}
+
+    PixelResult operator*() const {
+      const auto w = static_cast<std::size_t>(width_);
+      return {static_cast<int>(i_ % w), y0_ + static_cast<int>(i_ / w),
+              x_[i_], y_[i_]};
+    }
+    PixelResult operator[](difference_type n) const { return *(*this + n); }
+    const_iterator &operator++() {
+      ++i_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator t = *this;
+      ++i_;
+      return t;
+    }
+    const_iterator &operator--() {
+      --i_;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator t = *this;
+      --i_;
+      return t;
+    }
+    const_iterator &operator+=(difference_type n) {
+      i_ = static_cast<std::size_t>(static_cast<difference_type>(i_) + n);
+      return *this;
+    }
+    const_iterator &operator-=(difference_type n) { return *this += -n; }
+    friend const_iterator operator+(const_iterator a, difference_type n) {
+      return a += n;
+    }
+    friend const_iterator operator+(difference_type n, const_iterator a) {
+      return a += n;
+    }
+    friend const_iterator operator-(const_iterator a, difference_type n) {
+      return a -= n;
+    }
+    friend difference_type operator-(const const_iterator &a,
+                                     const const_iterator &b) {
+      return static_cast<difference_type>(a.i_) -
+             static_cast<difference_type>(b.i_);
+    }
+    friend bool operator==(const const_iterator &a, const const_iterator &b) {
+      return a.i_ == b.i_;
+    }
+    friend auto operator<=>(const const_iterator &a, const const_iterator &b) {
+      return a.i_ <=> b.i_;
+    }
+
+  private:
+    const double *x_ = nullptr;
+    const double *y_ = nullptr;
+    int width_ = 0;
+    int y0_ = 0;
+    std::size_t i_ = 0;
+  };
+
+  const_iterator begin() const { return {*this, 0}; }
+  const_iterator end() const { return {*this, size()}; }
+};
+
+// Owning result of compute_grid() in structure-of-arrays form: x and y in
+// separate 64-byte aligned arrays, 16 bytes per pixel against the 24 of a
+// PixelResult, whose px/py are implied by the row-major index.
+class GridResult {
+public:
+  GridResult() = default;
+  GridResult(int width, int height) { resize(width, height); }
+
+  // Keeps the allocations when they are large enough; the values are
+  // unspecified afterwards. Extra arrays are allocated for the channels
+  // among `channels` beyond x and y (iterations also for smooth), and
+  // released otherwise.
+  void resize(int width, int height,
+              const std::vector<Channel> &channels = {}) {
+    width_ = width;
+    height_ = height;
+    const std::size_t n =
+        static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    auto want = [&](Channel c) { return has_channel(channels, c); };
+    x_.resize(n);
+    y_.resize(n);
+    const bool smooth = want(Channel::smooth);
+    fit(it_, want(Channel::iterations) || smooth ? n : 0);
+    fit(escaped_, want(Channel::escaped) ? n : 0);
+    fit(smooth_, smooth ? n : 0);
+  }
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  std::size_t size() const { return x_.size(); }
+  double *x() { return x_.data(); }
+  double *y() { return y_.data(); }
+  const double *x() const { return x_.data(); }
+  const double *y() const { return y_.data(); }
+  // Extra channels: null unless allocated by resize().
+  std::uint32_t *iterations() { return data(it_); }
+  std::uint8_t *escaped() { return data(escaped_); }
+  double *smooth() { return data(smooth_); }
+  const std::uint32_t *iterations() const { return data(it_); }
+  const std::uint8_t *escaped() const { return data(escaped_); }
+  const double *smooth() const { return data(smooth_); }
+
+  // Rows [y0, y0 + rows) of the image.
+  GridView rows(int y0, int rows) const {
+    const std::size_t i =
+        static_cast<std::size_t>(y0) * static_cast<std::size_t>(width_);
+    GridView v{x_.data() + i, y_.data() + i, width_, y0, rows};
+    if (!it_.empty())
+      v.iterations = it_.data() + i;
+    if (!escaped_.empty())
+      v.escaped = escaped_.data() + i;
+    if (!smooth_.empty())
+      v.smooth = smooth_.data() + i;
+    return v;
+  }
+  GridView view() const { return rows(0, height_); }
+
+  // PixelResult adaptors for code written against std::vector<PixelResult>.
+  // Iterators point into this object's arrays, like vector iterators.
+  PixelResult operator[](std::size_t i) const { return view()[i]; }
+  GridView::const_iterator begin() const { return view().begin(); }
+  GridView::const_iterator end() const { return view().end(); }
+
+private:
+  template <class T> static void fit(AlignedVector<T> &v, std::size_t n) {
+    if (n == 0)
+      AlignedVector<T>().swap(v);
+    else
+      v.resize(n);
+  }
+  template <class T> static T *data(AlignedVector<T> &v) {
+    return v.empty() ? nullptr : v.data();
+  }
+  template <class T> static const T *data(const AlignedVector<T> &v) {
+    return v.empty() ? nullptr : v.data();
+  }
+
+  int width_ = 0;
+  int height_ = 0;
+  AlignedVector<double> x_;
+  AlignedVector<double> y_;
+  AlignedVector<std::uint32_t> it_;
+  AlignedVector<std::uint8_t> escaped_;
+  AlignedVector<double> smooth_;
+};
+
+// Offset of pixel (px,py) from the view center in the complex plane.
+inline std::pair<double, double> pixel_offset(const Params &p, int px,
+                                              int py) {
+  const double dx =
+      (static_cast<double>(px) - static_cast<double>(p.width) / 2.0) * p.scale;
+  const double dy =
+      (static_cast<double>(py) - static_cast<double>(p.height) / 2.0) *
+      p.scale;
+  return {dx, dy};
+}
+
 // Map pixel (px,py) to complex plane constant c = (cx, cy) using Params.
 inline std::pair<double, double> map_pixel_to_plane(const Params &p, int px,
                                                     int py) {
-  const double cx =
-      p.center_x +
-      (static_cast<double>(px) - static_cast<double>(p.width) / 2.0) * p.scale;
-  const double cy =
-      p.center_y +
-      (static_cast<double>(py) - static_cast<double>(p.height) / 2.0) * p.scale;
-  return {cx, cy};
+  const auto [dx, dy] = pixel_offset(p, px, py);
+  return {p.center_x + dx, p.center_y + dy};
 }
 
 // Return final z after iterating z_{n+1} = z_n^2 + c starting from z0 = 0
@@ -39,13 +363,143 @@ inline std::pair<double, double> map_pixel_to_plane(const Params &p, int px,
 std::pair<double, double> mandelbrot_last_state(double cx, double cy,
                                                 int max_iters);
 
-// Compute full grid results into out (size: width*height). Deterministic,
-// single-threaded. Each PixelResult stores the final z = (x,y) reached at
-// termination.
+// mandelbrot_last_state() with Brent cycle detection (see
+// Params::cycle_tol). Once z_n repeats z_{n-p}, the orbit is periodic, so
+// the state at max_iters is reached by advancing (max_iters - n) mod p more
+// steps instead of iterating to the end. tol < 0 disables detection. If
+// iters is non-null it receives the iterations run (max_iters once a cycle
+// is found).
+std::pair<double, double> mandelbrot_last_state_periodic(double cx, double cy,
+                                                         int max_iters,
+                                                         double tol,
+                                                         int *iters = nullptr);
+
+// Compute full grid results into out, resized to p.width x p.height. The
+// image is split into tiles that are spread over p.threads threads with work
+// stealing; the output is identical for every thread count. Each pixel
+// stores the final z = (x,y) reached at termination.
+void compute_grid(const Params &p, GridResult &out);
+
+// Same as above, but runs on an existing pool (p.threads is ignored).
+void compute_grid(const Params &p, GridResult &out, ThreadPool &pool);
+
+// compute_grid() into PixelResult rows (width*height, row-major), for
+// existing callers; converts from a GridResult.
 void compute_grid(const Params &p, std::vector<PixelResult> &out);
+void compute_grid(const Params &p, std::vector<PixelResult> &out,
+                  ThreadPool &pool);
+
+// compute_grid() for a view that overlaps an earlier one, e.g. a pan at
+// the same scale: pixels whose c is bit for bit the c of a pixel of prev
+// (computed with prev_params) are copied from it, and only the others are
+// computed, so out is identical to compute_grid(p, out). Reuse requires
+// the same scale, the same per-pixel settings (max_iters, interior,
+// cycle_tol, precision f32 or f64, Engine::grid or subdivide with
+// Fill::exact) and every extra channel of p in prev; otherwise, or if the
+// views are not offset by a whole number of pixels, the whole grid is
+// computed. Returns the number of pixels copied.
+std::size_t compute_grid_incremental(const Params &prev_params,
+                                     const GridResult &prev, const Params &p,
+                                     GridResult &out);
+std::size_t compute_grid_incremental(const Params &prev_params,
+                                     const GridResult &prev, const Params &p,
+                                     GridResult &out, ThreadPool &pool);
+
+// Receives finished image rows [rows.y0, rows.y0 + rows.rows), full width.
+// Calls arrive in increasing y0 order on the thread that called
+// compute_grid_streaming(); the view is only valid during the call.
+using RowSink = std::function<void(const GridView &rows)>;
+
+// compute_grid() without materializing the image: rows are computed in
+// full-width bands of tiles, and at most `ring_bands` bands are in flight
+// (0: enough to keep the pool busy). Workers keep computing later bands
+// while the sink consumes the oldest one, so peak memory depends on the
+// width and thread count but not on the height, except that rows mirrored
+// by Params::symmetry keep their source row alive until they are emitted
+// (up to half the image for center_y = 0). Results are identical to
+// compute_grid().
+void compute_grid_streaming(const Params &p, const RowSink &sink,
+                            int ring_bands = 0);
+void compute_grid_streaming(const Params &p, const RowSink &sink,
+                            ThreadPool &pool, int ring_bands = 0);
+
+// Receives finished rows of frame `frame` (an index into the sequence
+// given to compute_frames_streaming()), like a RowSink. Frames arrive in
+// order, each from its row 0 to its last row.
+using FrameSink =
+    std::function<void(std::size_t frame, const GridView &rows)>;
+
+// compute_grid_streaming() for a sequence of grids, e.g. the frames of a
+// zoom. The ring of bands runs on across frame boundaries: while the sink
+// consumes the last rows of one frame (and finishes its output), workers
+// already compute the next one, and the band buffers are reused by every
+// frame. Each frame is identical to compute_grid() with its own Params;
+// threads is taken from the first.
+void compute_frames_streaming(const std::vector<Params> &frames,
+                              const FrameSink &sink, int ring_bands = 0);
+void compute_frames_streaming(const std::vector<Params> &frames,
+                              const FrameSink &sink, ThreadPool &pool,
+                              int ring_bands = 0);
+
+// On-disk layouts for grid results. Columns follow Params::channels
+// (x, y by default).
+enum class OutputFormat {
+  csv, // text, header px,py,<channels>, one row per pixel
+  npy, // NumPy .npy, float64 array of shape (channels, height, width)
+  raw  // headerless little-endian columns + <path>.json sidecar; each
+       // channel keeps its own dtype
+};
+
+const char *format_name(OutputFormat f);
+// Throws std::runtime_error on unknown names.
+OutputFormat parse_format(const std::string &name);
+
+// Column name of a channel: x, y, it, escaped, smooth.
+const char *channel_name(Channel c);
+// Comma-separated channel names, e.g. "it,x,y,smooth". Throws
+// std::runtime_error on unknown or repeated names, or an empty list.
+std::vector<Channel> parse_channels(const std::string &list);
+
+struct WriterOptions {
+  // raw only: append int32 px and py columns. csv always carries them and
+  // npy leaves them implicit in the array shape.
+  bool coords = false;
+};
+
+// Sink for a grid of results, fed in row-major pixel order. The binary
+// formats store each channel as a contiguous column that can be
+// memory-mapped without parsing (np.load(path, mmap_mode="r") for npy,
+// np.memmap with the sidecar's offsets for raw).
+class GridWriter {
+public:
+  virtual ~GridWriter() = default;
+  // Switch to a new output file, keeping internal buffers, so one writer
+  // can serve a series of grids. Call between finish() and begin().
+  virtual void reopen(const std::string &path) = 0;
+  // Called once, before any results.
+  virtual void begin(const Params &p) = 0;
+  // The next rows of the image, in order. Throws if rows lack one of the
+  // channels of begin()'s Params.
+  virtual void write(const GridView &rows) = 0;
+  // Flush everything and close the output. Throws on I/O errors.
+  virtual void finish() = 0;
+};
+
+// Opens path for writing (throws if that fails).
+std::unique_ptr<GridWriter> make_writer(OutputFormat format,
+                                        const std::string &path,
+                                        const WriterOptions &opts = {});
+
+// begin() + write() + finish() for a fully computed grid.
+void write_grid(GridWriter &w, const Params &p, const GridResult &data);
 
-// Write results to CSV path with header: px,py,x,y
+// Write the x and y channels to CSV path with header: px,py,x,y. Doubles
+// use the shortest representation that round-trips (std::to_chars); rows
+// are formatted into a large buffer that is written out in few big writes.
 // Throws on file I/O errors.
+void write_csv(const std::string &path, const GridResult &data);
+// The same for PixelResult rows (e.g. from the std::vector overload of
+// compute_grid), one line each in the order given.
 void write_csv(const std::string &path, const std::vector<PixelResult> &data);
 
 } // namespace mandel
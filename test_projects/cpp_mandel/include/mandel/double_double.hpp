@@ -0,0 +1,78 @@
+#pragma once
+#include <string_view>
+
+namespace mandel {
+
+// Double-double number: the unevaluated sum hi + lo of two doubles with
+// |lo| <= ulp(hi) / 2, giving about 106 significant bits (32 decimal
+// digits). The error-free transforms below rely on strict IEEE double
+// evaluation, which the library is built for (-ffp-contract=off).
+struct DoubleDouble {
+  double hi = 0.0;
+  double lo = 0.0;
+};
+
+namespace dd_detail {
+
+// s + e == a + b exactly.
+inline DoubleDouble two_sum(double a, double b) {
+  const double s = a + b;
+  const double bb = s - a;
+  return {s, (a - (s - bb)) + (b - bb)};
+}
+
+// As two_sum, for |a| >= |b|.
+inline DoubleDouble quick_two_sum(double a, double b) {
+  const double s = a + b;
+  return {s, b - (s - a)};
+}
+
+// p + e == a * b exactly (Dekker's product).
+inline DoubleDouble two_prod(double a, double b) {
+  constexpr double kSplit = 134217729.0; // 2^27 + 1
+  const double p = a * b;
+  const double ta = kSplit * a, tb = kSplit * b;
+  const double ah = ta - (ta - a), al = a - ah;
+  const double bh = tb - (tb - b), bl = b - bh;
+  return {p, ((ah * bh - p) + ah * bl + al * bh) + al * bl};
+}
+
+} // namespace dd_detail
+
+inline DoubleDouble operator-(DoubleDouble a) { return {-a.hi, -a.lo}; }
+
+inline DoubleDouble operator+(DoubleDouble a, DoubleDouble b) {
+  DoubleDouble s = dd_detail::two_sum(a.hi, b.hi);
+  const DoubleDouble t = dd_detail::two_sum(a.lo, b.lo);
+  s.lo += t.hi;
+  s = dd_detail::quick_two_sum(s.hi, s.lo);
+  s.lo += t.lo;
+  return dd_detail::quick_two_sum(s.hi, s.lo);
+}
+
+inline DoubleDouble operator-(DoubleDouble a, DoubleDouble b) {
+  return a + (-b);
+}
+
+inline DoubleDouble operator*(DoubleDouble a, DoubleDouble b) {
+  DoubleDouble p = dd_detail::two_prod(a.hi, b.hi);
+  p.lo += a.hi * b.lo + a.lo * b.hi;
+  return dd_detail::quick_two_sum(p.hi, p.lo);
+}
+
+inline DoubleDouble operator/(DoubleDouble a, DoubleDouble b) {
+  const double q1 = a.hi / b.hi;
+  DoubleDouble r = a - b * DoubleDouble{q1, 0.0};
+  const double q2 = r.hi / b.hi;
+  r = r - b * DoubleDouble{q2, 0.0};
+  const double q3 = r.hi / b.hi;
+  return dd_detail::quick_two_sum(q1, q2) + DoubleDouble{q3, 0.0};
+}
+
+// Parse a decimal number such as "-1.7687788", ".5" or "3e-25" (surrounding
+// blanks allowed) to the nearest double-double, within a few units of its
+// last bit. Throws
+// std::runtime_error if text is not a number.
+DoubleDouble parse_double_double(std::string_view text);
+
+} // namespace mandel
@@ -0,0 +1,107 @@
+#pragma once
+#include "mandel/core.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace mandel {
+
+// A queue of independent pixels for the batch kernels. Pixel i has
+// c = (cx[i], cy[i]); its final z is written to (zx[i], zy[i]).
+template <class T> struct BasicPixelBatch {
+  const T *cx;
+  const T *cy;
+  std::size_t n;
+  int max_iters;
+  T *zx;
+  T *zy;
+  double cycle_tol = -1.0; // Params::cycle_tol; double escape kernels only
+  // Escape kernels only, and only when non-null: iterations run for pixel
+  // i (max_iters for orbits that never escaped, including detected cycles).
+  std::uint32_t *iters = nullptr;
+};
+
+using PixelBatch = BasicPixelBatch<double>;
+using PixelBatchF32 = BasicPixelBatch<float>;
+
+using BatchKernelFn = void (*)(const PixelBatch &);
+using BatchKernelF32Fn = void (*)(const PixelBatchF32 &);
+
+// Reference batch kernel: mandelbrot_last_state() for each pixel, or
+// mandelbrot_last_state_periodic() when b.cycle_tol >= 0.
+void scalar_kernel(const PixelBatch &b);
+
+// scalar_kernel() that runs K iterations per block with a single bailout
+// test at the end. Once |z| > 2 the orbit grows monotonically, so an escape
+// anywhere in the block is still visible (as |z| > 2, inf or NaN) after it;
+// the block is then replayed from its saved state with the per-iteration
+// test, so the final z is bit-identical. Falls back to scalar_kernel() when
+// b.cycle_tol >= 0.
+template <int K> void unrolled_kernel(const PixelBatch &b);
+
+// unrolled_kernel<k> for k = 2, 4, 8 or 16; scalar_kernel for k = 1.
+// Throws std::runtime_error for any other k.
+BatchKernelFn unrolled_kernel_fn(int k);
+
+// Analytic test for the main cardioid and the period-2 bulb. Points inside
+// never escape, so their final z is the state after exactly max_iters steps.
+inline bool in_cardioid_or_bulb(double cx, double cy) {
+  const double xq = cx - 0.25;
+  const double y2 = cy * cy;
+  const double q = xq * xq + y2;
+  if (q * (q + xq) <= 0.25 * y2)
+    return true;
+  const double xb = cx + 1.0;
+  return xb * xb + y2 <= 0.0625;
+}
+
+// Interior::exact for points that passed in_cardioid_or_bulb(): iterate
+// exactly max_iters steps with no bailout test. Same operations as
+// mandelbrot_last_state(), so the result is bit-identical for such points.
+void interior_exact_kernel(const PixelBatch &b);
+
+// Interior::attractor: closed-form limit of the orbit. Cardioid points
+// return z* = (1 - sqrt(1 - 4c)) / 2; bulb points return the 2-cycle point
+// (-1 +/- sqrt(-3 - 4c)) / 2 that even (+) or odd (-) iterates approach,
+// picked by the parity of max_iters.
+void interior_attractor_kernel(const PixelBatch &b);
+
+// True when kernel k is compiled into this binary and the running CPU
+// (CPUID + OS register-state support) can execute it.
+bool kernel_supported(Kernel k);
+
+// Kernel::automatic -> the widest supported kernel; any other value is
+// returned unchanged if supported. Throws std::runtime_error otherwise.
+Kernel resolve_kernel(Kernel k);
+
+// Entry point of a resolved kernel.
+BatchKernelFn kernel_fn(Kernel k);
+
+// interior_exact_kernel() vectorized with the same ISA as kernel k.
+BatchKernelFn interior_exact_fn(Kernel k);
+
+// Precision::f32 kernels: last_state<float>() for each pixel, bit for bit,
+// with twice as many lanes per vector as the double kernels. No cycle
+// detection (b.cycle_tol is ignored).
+void scalar_kernel_f32(const PixelBatchF32 &b);
+// interior_exact_kernel() in float.
+void interior_exact_kernel_f32(const PixelBatchF32 &b);
+BatchKernelF32Fn kernel_f32_fn(Kernel k);
+
+const char *kernel_name(Kernel k);
+const char *interior_name(Interior m);
+const char *engine_name(Engine e);
+const char *fill_name(Fill f);
+const char *precision_name(Precision p);
+const char *schedule_name(Schedule s);
+
+// Inverse of kernel_name(); accepts "auto" for Kernel::automatic.
+// Throws std::runtime_error on unknown names.
+Kernel parse_kernel(std::string_view name);
+Interior parse_interior(std::string_view name);
+Engine parse_engine(std::string_view name);
+Fill parse_fill(std::string_view name);
+Precision parse_precision(std::string_view name);
+Schedule parse_schedule(std::string_view name);
+
+} // namespace mandel
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mandel {
+
+class Tracer;
+
+// Half-open pixel rectangle [x0, x1) x [y0, y1).
+struct Tile {
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+};
+
+// Split a width x height image into row-major tiles of at most
+// tile_w x tile_h pixels.
+std::vector<Tile> make_tiles(int width, int height, int tile_w, int tile_h);
+
+// Resolve a user-facing thread count: values <= 0 mean "all hardware
+// threads". Always returns at least 1.
+int resolve_threads(int requested);
+
+// Completion tracker for a set of tasks submitted to a ThreadPool. The first
+// exception thrown by any task is rethrown from ThreadPool::wait.
+class TaskGroup {
+public:
+  TaskGroup() = default;
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  bool done() const noexcept { return pending_.load() == 0; }
+
+private:
+  friend class ThreadPool;
+  std::atomic<std::size_t> pending_{0};
+  std::mutex error_mu_;
+  std::exception_ptr error_{};
+};
+
+// Work-stealing pool. `threads` counts every participant, including the
+// thread that calls wait(): a pool of size 1 spawns no workers and runs all
+// tasks inline, in submission order. Each participant owns a deque; owners
+// pop from the front and idle participants steal from the back of others,
+// skipping tasks submitted with Deal::pinned.
+//
+// submit()/wait() must be called from the thread that owns the pool.
+//
+// With a tracer, every participant records the time it spends blocked
+// with nothing to run (TraceKind::wait); tasks can record their own spans
+// through tracer(). The tracer must outlive the pool.
+class ThreadPool {
+public:
+  using IndexFn = std::function<void(std::size_t index, int worker)>;
+
+  // How submit() spreads indices over the participants' deques.
+  enum class Deal {
+    chunks,      // contiguous chunks, one per participant
+    interleaved, // round robin: each deque gets every n-th index, so indices
+                 // sorted by decreasing cost are taken costliest first
+    pinned       // contiguous chunks that are never stolen: chunk q runs on
+                 // participant q even while others are idle
+  };
+
+  explicit ThreadPool(int threads, Tracer *tracer = nullptr);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Number of participants (workers + the owning thread).
+  int size() const noexcept { return static_cast<int>(queues_.size()); }
+
+  // Null when not tracing.
+  Tracer *tracer() const noexcept { return tracer_; }
+
+  // Enqueue fn(i, worker) for i in [0, count) as part of group. By default
+  // indices are dealt to participants in contiguous chunks so neighbouring
+  // tiles stay on one core until stolen. fn must outlive wait(group).
+  void submit(TaskGroup &group, std::size_t count, const IndexFn &fn,
+              Deal deal = Deal::chunks);
+
+  // Block until every task of group has finished. The owning thread runs
+  // queued tasks while it waits.
+  void wait(TaskGroup &group);
+
+  // submit() + wait() on a private group.
+  void parallel_for(std::size_t count, const IndexFn &fn,
+                    Deal deal = Deal::chunks);
+
+private:
+  struct Task {
+    const IndexFn *fn;
+    std::size_t index;
+    TaskGroup *group;
+    bool pinned;
+  };
+  struct Queue {
+    std::mutex mu;
+    std::deque<Task> tasks;
+    std::atomic<long> pinned{0}; // pinned tasks in tasks
+  };
+
+  bool try_take(int self, Task &out);
+  void run(const Task &t, int self);
+  void worker_loop(int self);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::mutex mu_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::atomic<long> queued_{0}; // tasks that any participant may take
+  bool stop_ = false;
+  Tracer *const tracer_;
+};
+
+} // namespace mandel
@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mandel {
+
+// Hardware events counted by PerfCounters, in user space only.
+enum class PerfEvent { cycles, instructions, branch_misses, cache_misses };
+
+inline constexpr std::size_t kPerfEvents = 4;
+
+// JSON-style name: cycles, instructions, branch_misses, cache_misses.
+const char *perf_event_name(PerfEvent e);
+
+// Event totals; a count is meaningful only where PerfCounters::has() is
+// true. Counts of multiplexed events are scaled from the fraction of time
+// they were scheduled, so they are estimates.
+struct PerfSample {
+  std::array<std::uint64_t, kPerfEvents> count{};
+
+  std::uint64_t operator[](PerfEvent e) const {
+    return count[static_cast<std::size_t>(e)];
+  }
+  PerfSample &operator+=(const PerfSample &o) {
+    for (std::size_t i = 0; i < kPerfEvents; ++i)
+      count[i] += o.count[i];
+    return *this;
+  }
+  // Saturates at 0: scaled estimates are not monotonic.
+  PerfSample &operator-=(const PerfSample &o) {
+    for (std::size_t i = 0; i < kPerfEvents; ++i)
+      count[i] = count[i] > o.count[i] ? count[i] - o.count[i] : 0;
+    return *this;
+  }
+};
+
+// perf_event_open(2) counters for the hardware events (Linux only).
+// Scope::process counts the calling thread and every thread it creates
+// afterwards, so it must be opened before the ThreadPool; Scope::thread
+// counts the calling thread alone. Opening never throws: events the
+// kernel refuses (perf_event_paranoid, no PMU in a virtual machine,
+// another OS) are left out, and reason() says why.
+class PerfCounters {
+public:
+  enum class Scope { process, thread };
+
+  explicit PerfCounters(Scope scope);
+  ~PerfCounters();
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool has(PerfEvent e) const { return fd_[static_cast<std::size_t>(e)] >= 0; }
+  // At least one event is counted.
+  bool available() const;
+  // Why events are missing; empty when all are counted.
+  const std::string &reason() const { return reason_; }
+
+  // Totals so far; zero for missing events.
+  PerfSample read() const;
+
+private:
+  std::array<int, kPerfEvents> fd_;
+  std::string reason_;
+};
+
+} // namespace mandel
@@ -0,0 +1,87 @@
+#pragma once
+#include "mandel/core.hpp"
+#include "mandel/double_double.hpp"
+#include <utility>
+#include <vector>
+
+namespace mandel {
+
+// Orbit Z_0 = 0, Z_{n+1} = Z_n^2 + C of a reference point C, iterated in
+// double-double and stored rounded to double. Ends after max_iters steps
+// or at the first Z with |Z| > 2, whichever comes first.
+struct ReferenceOrbit {
+  std::vector<double> re; // real(Z_n), n = 0 .. size() - 1
+  std::vector<double> im; // imag(Z_n)
+  std::size_t size() const { return re.size(); }
+};
+
+ReferenceOrbit reference_orbit(DoubleDouble cx, DoubleDouble cy,
+                               int max_iters);
+
+// The view center at full precision: Params::center_x_text and
+// center_y_text when set, else center_x and center_y.
+std::pair<DoubleDouble, DoubleDouble> view_center(const Params &p);
+
+// Final z (as mandelbrot_last_state) of c = C + dc, where C is the
+// reference point of ref. Only the delta dz_n = z_n - Z_n is iterated, in
+// double:
+//
+//   dz_{n+1} = 2 Z_n dz_n + dz_n^2 + dc
+//
+// which keeps full relative precision in dz however small dc is. When
+// |z_n| < |dz_n| the delta has become too large for that to hold (a
+// glitch), and when the reference ends there is no Z_n left. In both
+// cases the delta is rebased onto the start of the orbit (dz = z_n,
+// n = 0; valid because Z_0 = 0), so one reference serves every pixel.
+//
+// The iteration may also start from a delta dz_start at step `start` (as
+// produced by SeriesApproximation), which must lie before the end of ref.
+// If iters is non-null it receives the iterations run, counting the
+// skipped ones.
+std::pair<double, double> perturbed_last_state(const ReferenceOrbit &ref,
+                                               double dcx, double dcy,
+                                               int max_iters, int start = 0,
+                                               double dzr_start = 0.0,
+                                               double dzi_start = 0.0,
+                                               int *iters = nullptr);
+
+// Truncated Taylor series of the perturbation delta in dc, which advances
+// every pixel near the reference past its first iterations at once:
+//
+//   dz_n ~= sum_{k=1..order} A_{n,k} dc^k
+//
+// with A_{0,k} = 0 and, substituting into dz_{n+1} = 2 Z_n dz_n + dz_n^2 +
+// dc and matching powers of dc,
+//
+//   A_{n+1,1} = 2 Z_n A_{n,1} + 1
+//   A_{n+1,k} = 2 Z_n A_{n,k} + sum_{i+j=k} A_{n,i} A_{n,j}
+//
+// Coefficients are stored scaled by radius^k (dc is taken in units of the
+// view radius) so they stay in range at any depth. Step n may be skipped
+// by all |dc| <= r when, at every step up to n, the first dropped term
+// A_{m,order+1} r^(order+1) is at most tol times the linear term, and the
+// bound |dz_m| <= sum_k |A_{m,k}| r^k proves that no pixel escapes or
+// would be rebased (|Z_m + dz_m| < |dz_m|) before step n.
+class SeriesApproximation {
+public:
+  // Coefficients are built until no |dc| >= min_radius can skip further,
+  // or the reference ends.
+  SeriesApproximation(const ReferenceOrbit &ref, int order, double tol,
+                      double radius, double min_radius);
+
+  // Number of iterations every |dc| <= r can skip (0 if none).
+  int skip(double r) const;
+
+  // dz_n at dc, for 0 <= n <= skip(|dc|).
+  std::pair<double, double> delta(int n, double dcx, double dcy) const;
+
+private:
+  int order_;
+  double radius_;
+  // A_{n,k} * radius^k for k = 1..order+1, at [n * (order + 1) + k - 1].
+  std::vector<double> re_, im_;
+  // limit_[n]: largest |dc| that may skip n steps; non-increasing.
+  std::vector<double> limit_;
+};
+
+} // namespace mandel
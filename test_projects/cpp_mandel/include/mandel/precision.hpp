@@ -0,0 +1,87 @@
+#pragma once
+#include "mandel/core.hpp"
+#include "mandel/double_double.hpp"
+#include "mandel/quad_double.hpp"
+#include <utility>
+
+namespace mandel {
+
+// Scalar policies for the escape loop: how to make a T from a double, read
+// back its leading double, and apply the bailout test. `epsilon` is the
+// unit roundoff that Precision::automatic compares against the pixel
+// spacing.
+template <class T> struct ScalarPolicy;
+
+template <> struct ScalarPolicy<float> {
+  static constexpr Precision precision = Precision::f32;
+  static constexpr double epsilon = 0x1p-24;
+  static float from_double(double v) { return static_cast<float>(v); }
+  static double to_double(float v) { return v; }
+  static bool bounded(float zr, float zi) {
+    return (zr * zr + zi * zi) <= 4.0f;
+  }
+};
+
+template <> struct ScalarPolicy<double> {
+  static constexpr Precision precision = Precision::f64;
+  static constexpr double epsilon = 0x1p-53;
+  static double from_double(double v) { return v; }
+  static double to_double(double v) { return v; }
+  static bool bounded(double zr, double zi) {
+    return (zr * zr + zi * zi) <= 4.0;
+  }
+};
+
+// The software types test the bailout on their leading double, which
+// decides |z| > 2 except within an ulp of the circle.
+template <> struct ScalarPolicy<DoubleDouble> {
+  static constexpr Precision precision = Precision::dd;
+  static constexpr double epsilon = 0x1p-106;
+  static DoubleDouble from_double(double v) { return {v, 0.0}; }
+  static double to_double(const DoubleDouble &v) { return v.hi; }
+  static bool bounded(const DoubleDouble &zr, const DoubleDouble &zi) {
+    return (zr.hi * zr.hi + zi.hi * zi.hi) <= 4.0;
+  }
+};
+
+template <> struct ScalarPolicy<QuadDouble> {
+  static constexpr Precision precision = Precision::qd;
+  static constexpr double epsilon = 0x1p-212;
+  static QuadDouble from_double(double v) { return {{v, 0.0, 0.0, 0.0}}; }
+  static double to_double(const QuadDouble &v) { return v.x[0]; }
+  static bool bounded(const QuadDouble &zr, const QuadDouble &zi) {
+    return (zr.x[0] * zr.x[0] + zi.x[0] * zi.x[0]) <= 4.0;
+  }
+};
+
+// mandelbrot_last_state() in precision T, with the final z rounded to
+// double. last_state<double> is mandelbrot_last_state() itself. If iters
+// is non-null it receives the number of iterations run.
+template <class T>
+std::pair<double, double> last_state(const T &cx, const T &cy, int max_iters,
+                                     int *iters = nullptr) {
+  using S = ScalarPolicy<T>;
+  const T two = S::from_double(2.0);
+  T zr = S::from_double(0.0), zi = S::from_double(0.0);
+  int it = 0;
+  while (it < max_iters && S::bounded(zr, zi)) {
+    const T zr2 = zr * zr - zi * zi + cx;
+    const T zi2 = two * zr * zi + cy;
+    zr = zr2;
+    zi = zi2;
+    ++it;
+  }
+  if (iters)
+    *iters = it;
+  return {S::to_double(zr), S::to_double(zi)};
+}
+
+// Precision::automatic -> the cheapest precision whose rounding of c stays
+// below 1/1024 of the pixel spacing (p.scale) anywhere in the view; other
+// values are returned unchanged. Only Engine::grid has a choice: the other
+// engines resolve to f64. Throws std::runtime_error if even quad-double is
+// too coarse, or if a precision other than f64 is requested for an engine
+// other than grid.
+Precision resolve_precision(const Params &p);
+
+} // namespace mandel
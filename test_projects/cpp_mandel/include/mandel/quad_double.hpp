@@ -0,0 +1,141 @@
+#pragma once
+#include "mandel/double_double.hpp"
+#include <string_view>
+
+namespace mandel {
+
+// Quad-double number: the unevaluated sum x[0] + x[1] + x[2] + x[3] of
+// four non-overlapping doubles, giving about 212 significant bits (64
+// decimal digits). Arithmetic follows the "sloppy" algorithms of Hida, Li
+// and Bailey's QD library, accurate to a few units of the last component.
+struct QuadDouble {
+  double x[4] = {0.0, 0.0, 0.0, 0.0};
+};
+
+namespace qd_detail {
+
+using dd_detail::quick_two_sum;
+using dd_detail::two_prod;
+using dd_detail::two_sum;
+
+// (a, b, c) <- a + b + c as a sum of three, largest first.
+inline void three_sum(double &a, double &b, double &c) {
+  const DoubleDouble t1 = two_sum(a, b);
+  const DoubleDouble t2 = two_sum(c, t1.hi);
+  const DoubleDouble t3 = two_sum(t1.lo, t2.lo);
+  a = t2.hi;
+  b = t3.hi;
+  c = t3.lo;
+}
+
+// (a, b) <- a + b + c as a sum of two (the remainder is dropped).
+inline void three_sum2(double &a, double &b, double c) {
+  const DoubleDouble t1 = two_sum(a, b);
+  const DoubleDouble t2 = two_sum(c, t1.hi);
+  a = t2.hi;
+  b = t1.lo + t2.lo;
+}
+
+// Normalize c0 + ... + c4 into four non-overlapping components.
+inline QuadDouble renorm(double c0, double c1, double c2, double c3,
+                         double c4) {
+  DoubleDouble t = quick_two_sum(c3, c4);
+  c4 = t.lo;
+  t = quick_two_sum(c2, t.hi);
+  c3 = t.lo;
+  t = quick_two_sum(c1, t.hi);
+  c2 = t.lo;
+  t = quick_two_sum(c0, t.hi);
+  c0 = t.hi;
+  c1 = t.lo;
+
+  double s[4] = {c0, c1, 0.0, 0.0};
+  int k = 1; // s[k] is the component being accumulated
+  for (double c : {c2, c3, c4}) {
+    if (s[k] != 0.0) {
+      t = quick_two_sum(s[k], c);
+      s[k] = t.hi;
+      if (k == 3) {
+        s[3] += t.lo; // out of components: fold the rest in
+        continue;
+      }
+      s[++k] = t.lo;
+    } else {
+      t = quick_two_sum(s[k - 1], c);
+      s[k - 1] = t.hi;
+      s[k] = t.lo;
+    }
+  }
+  return {{s[0], s[1], s[2], s[3]}};
+}
+
+} // namespace qd_detail
+
+inline QuadDouble operator-(const QuadDouble &a) {
+  return {{-a.x[0], -a.x[1], -a.x[2], -a.x[3]}};
+}
+
+inline QuadDouble operator+(const QuadDouble &a, const QuadDouble &b) {
+  using namespace qd_detail;
+  const DoubleDouble s0 = two_sum(a.x[0], b.x[0]);
+  const DoubleDouble s1 = two_sum(a.x[1], b.x[1]);
+  const DoubleDouble s2 = two_sum(a.x[2], b.x[2]);
+  const DoubleDouble s3 = two_sum(a.x[3], b.x[3]);
+  const DoubleDouble u = two_sum(s1.hi, s0.lo);
+  double r1 = u.hi, t0 = u.lo;
+  double r2 = s2.hi, t1 = s1.lo, t2 = s2.lo;
+  three_sum(r2, t0, t1);
+  double r3 = s3.hi;
+  three_sum2(r3, t0, t2);
+  t0 = t0 + t1 + s3.lo;
+  return renorm(s0.hi, r1, r2, r3, t0);
+}
+
+inline QuadDouble operator-(const QuadDouble &a, const QuadDouble &b) {
+  return a + (-b);
+}
+
+inline QuadDouble operator*(const QuadDouble &a, const QuadDouble &b) {
+  using namespace qd_detail;
+  const DoubleDouble p0 = two_prod(a.x[0], b.x[0]);
+  const DoubleDouble p1 = two_prod(a.x[0], b.x[1]);
+  const DoubleDouble p2 = two_prod(a.x[1], b.x[0]);
+  const DoubleDouble p3 = two_prod(a.x[0], b.x[2]);
+  const DoubleDouble p4 = two_prod(a.x[1], b.x[1]);
+  const DoubleDouble p5 = two_prod(a.x[2], b.x[0]);
+
+  // Terms of order eps: (p1, p2, q0) -> three components.
+  double e1 = p1.hi, e2 = p2.hi, q0 = p0.lo;
+  three_sum(e1, e2, q0);
+  // Order eps^2: (e2, q1, q2) + (p3, p4, p5).
+  double q1 = p1.lo, q2 = p2.lo;
+  three_sum(e2, q1, q2);
+  double h3 = p3.hi, h4 = p4.hi, h5 = p5.hi;
+  three_sum(h3, h4, h5);
+  DoubleDouble s0 = two_sum(e2, h3);
+  DoubleDouble s1 = two_sum(q1, h4);
+  double s2 = q2 + h5;
+  const DoubleDouble u = two_sum(s1.hi, s0.lo);
+  s2 += u.lo + s1.lo;
+  // Order eps^3.
+  double s3 = u.hi + (a.x[0] * b.x[3] + a.x[1] * b.x[2] + a.x[2] * b.x[1] +
+                      a.x[3] * b.x[0] + q0 + p3.lo + p4.lo + p5.lo);
+  return renorm(p0.hi, e1, s0.hi, s3, s2);
+}
+
+inline QuadDouble operator/(const QuadDouble &a, const QuadDouble &b) {
+  // Long division: four quotient digits, each taken from the remainder.
+  double q[5];
+  QuadDouble r = a;
+  for (int i = 0; i < 4; ++i) {
+    q[i] = r.x[0] / b.x[0];
+    r = r - b * QuadDouble{{q[i], 0.0, 0.0, 0.0}};
+  }
+  q[4] = r.x[0] / b.x[0];
+  return qd_detail::renorm(q[0], q[1], q[2], q[3], q[4]);
+}
+
+// parse_double_double() to quad-double precision.
+QuadDouble parse_quad_double(std::string_view text);
+
+} // namespace mandel
@@ -0,0 +1,75 @@
+#pragma once
+#include "mandel/perf.hpp"
+#include <chrono>
+#include <cstdint>
+
+namespace mandel {
+
+// CPU time in seconds used so far by the whole process (every thread) and
+// by the calling thread; 0 where the platform cannot tell.
+double process_cpu_seconds();
+double thread_cpu_seconds();
+
+// Peak resident set size of the process in bytes; 0 where unknown.
+std::uint64_t peak_rss_bytes();
+
+// Wall-clock and CPU seconds spent in a phase of a run, and the hardware
+// events counted meanwhile (when a Stopwatch was given PerfCounters).
+struct PhaseTime {
+  double wall = 0.0;
+  double cpu = 0.0;
+  PerfSample perf;
+
+  PhaseTime &operator+=(const PhaseTime &o) {
+    wall += o.wall;
+    cpu += o.cpu;
+    perf += o.perf;
+    return *this;
+  }
+  PhaseTime &operator-=(const PhaseTime &o) {
+    wall -= o.wall;
+    cpu -= o.cpu;
+    perf -= o.perf;
+    return *this;
+  }
+};
+
+// Wall and CPU time since construction. The CPU time is the process's, or
+// only the calling thread's with Cpu::thread (for work that overlaps
+// other threads, e.g. a RowSink while workers compute). With perf, also
+// the events it counted, which should have the same scope.
+class Stopwatch {
+public:
+  enum class Cpu { process, thread };
+
+  explicit Stopwatch(Cpu cpu = Cpu::process,
+                     const PerfCounters *perf = nullptr)
+      : cpu_(cpu), perf_(perf), t0_(std::chrono::steady_clock::now()),
+        cpu0_(cpu_now()), perf0_(perf_ ? perf_->read() : PerfSample{}) {}
+
+  PhaseTime elapsed() const {
+    PhaseTime t{std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0_)
+                    .count(),
+                cpu_now() - cpu0_,
+                {}};
+    if (perf_) {
+      t.perf = perf_->read();
+      t.perf -= perf0_;
+    }
+    return t;
+  }
+
+private:
+  double cpu_now() const {
+    return cpu_ == Cpu::thread ? thread_cpu_seconds() : process_cpu_seconds();
+  }
+
+  Cpu cpu_;
+  const PerfCounters *perf_;
+  std::chrono::steady_clock::time_point t0_;
+  double cpu0_;
+  PerfSample perf0_;
+};
+
+} // namespace mandel
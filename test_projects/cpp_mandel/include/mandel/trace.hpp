@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mandel {
+
+// What a traced span covers; fixes its name, category and arguments.
+enum class TraceKind {
+  tile,   // a tile computed by a pool participant; args x0, y0, x1, y1
+  flush,  // rows passed to an output writer; args frame, y0, rows
+  finish, // an output writer flushing its buffers and closing; arg frame
+  wait,   // a participant blocked with no task to run; no args
+};
+
+// Span of one thread, in nanoseconds since the Tracer was created.
+struct TraceEvent {
+  TraceKind kind;
+  std::uint64_t begin;
+  std::uint64_t end;
+  std::array<int, 4> args;
+};
+
+// Timeline of tiles, writer flushes and queue waits, written in the Chrome
+// Trace Event format (chrome://tracing, ui.perfetto.dev). Each thread
+// appends to its own buffer without locking; the mutex is only taken the
+// first time a thread records. A thread records into one Tracer at a time.
+class Tracer {
+public:
+  Tracer();
+  Tracer(const Tracer &) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+
+  std::uint64_t now() const {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_)
+            .count());
+  }
+
+  // Appends a span to the calling thread's buffer. worker is its pool
+  // participant index, which names the thread in the timeline (0: main).
+  void record(int worker, TraceKind kind, std::uint64_t begin,
+              std::uint64_t end, std::array<int, 4> args = {});
+
+  // Summed duration of the spans of one kind recorded under pool
+  // participant index worker. Same conditions as write().
+  std::uint64_t total(TraceKind kind, int worker) const;
+
+  // Merges the buffers by start time and writes them to path. The
+  // recording threads must be finished (e.g. their pool destroyed).
+  // Throws std::runtime_error on I/O errors.
+  void write(const std::string &path) const;
+
+private:
+  struct Buffer {
+    int worker;
+    std::vector<TraceEvent> events;
+  };
+  Buffer &buffer(int worker);
+
+  const std::uint64_t id_; // tells the thread-local buffer caches apart
+  const std::chrono::steady_clock::time_point start_;
+  std::mutex mu_;
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+} // namespace mandel
@@ -0,0 +1,237 @@
+#include "mandel/cache.hpp"
+#include "mandel/kernels.hpp"
+#include "mandel/precision.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace mandel {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bump whenever a change alters the bytes written for the same key, so
+// that older entries stop matching.
+constexpr int kCacheVersion = 2;
+
+// Leftovers of processes that died while storing an entry.
+constexpr auto kStaleTemp = std::chrono::hours(1);
+
+std::string shortest(double v) {
+  char buf[32];
+  const auto [p, ec] = std::to_chars(buf, buf + sizeof buf, v);
+  return std::string(buf, ec == std::errc() ? p : buf);
+}
+
+std::string hex(std::uint64_t v) {
+  char buf[17];
+  std::snprintf(buf, sizeof buf, "%016llx",
+                static_cast<unsigned long long>(v));
+  return buf;
+}
+
+// Unique name for a private directory under the cache root.
+std::string temp_name() {
+  std::random_device rd;
+  const std::uint64_t r = (std::uint64_t{rd()} << 32) ^ rd();
+  return "tmp-" + hex(r);
+}
+
+bool is_temp(const fs::path &p) {
+  return p.filename().string().rfind("tmp-", 0) == 0;
+}
+
+// Replaces dst by a hardlink to src, or a copy when links are unsupported.
+bool place(const fs::path &src, const fs::path &dst) {
+  std::error_code ec;
+  fs::remove(dst, ec);
+  fs::create_hard_link(src, dst, ec);
+  if (!ec)
+    return true;
+  ec.clear();
+  fs::copy_file(src, dst, fs::copy_options::overwrite_existing, ec);
+  return !ec;
+}
+
+struct Entry {
+  fs::path path;
+  fs::file_time_type used;
+  std::uint64_t bytes = 0;
+};
+
+// Complete entries under dir; temporary directories are skipped (and
+// removed once stale when remove_stale is set).
+std::vector<Entry> list_entries(const fs::path &dir, bool remove_stale) {
+  std::vector<Entry> entries;
+  std::error_code ec;
+  const auto now = fs::file_time_type::clock::now();
+  for (const auto &d : fs::directory_iterator(dir, ec)) {
+    std::error_code e;
+    if (!d.is_directory(e))
+      continue;
+    const auto used = fs::last_write_time(d.path(), e);
+    if (e)
+      continue;
+    if (is_temp(d.path())) {
+      if (remove_stale && now - used > kStaleTemp)
+        fs::remove_all(d.path(), e);
+      continue;
+    }
+    Entry entry{d.path(), used, 0};
+    for (const auto &f : fs::directory_iterator(d.path(), e)) {
+      std::error_code fe;
+      const auto n = f.file_size(fe);
+      if (!fe)
+        entry.bytes += n;
+    }
+    entries.push_back(entry);
+  }
+  return entries;
+}
+
+} // namespace
+
+std::uint64_t fnv1a64(const std::string &s) {
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+std::string cache_key(const Params &p, OutputFormat format,
+                      const WriterOptions &opts) {
+  auto center = [](const std::string &text, double value) {
+    return text.empty() ? shortest(value) : text;
+  };
+  std::string channels;
+  for (Channel c : p.channels) {
+    if (!channels.empty())
+      channels += ',';
+    channels += channel_name(c);
+  }
+  std::string k = "mandel-cache " + std::to_string(kCacheVersion) + "\n";
+  k += "width=" + std::to_string(p.width) + "\n";
+  k += "height=" + std::to_string(p.height) + "\n";
+  k += "center_x=" + center(p.center_x_text, p.center_x) + "\n";
+  k += "center_y=" + center(p.center_y_text, p.center_y) + "\n";
+  k += "scale=" + shortest(p.scale) + "\n";
+  k += "max_iters=" + std::to_string(p.max_iters) + "\n";
+  k += std::string("precision=") + precision_name(resolve_precision(p)) +
+       "\n";
+  k += std::string("engine=") + engine_name(p.engine) + "\n";
+  k += std::string("fill=") + fill_name(p.fill) + "\n";
+  k += std::string("interior=") + interior_name(p.interior) + "\n";
+  k += "cycle_tol=" + shortest(p.cycle_tol) + "\n";
+  k += "series_order=" + std::to_string(p.series_order) + "\n";
+  k += "series_tol=" + shortest(p.series_tol) + "\n";
+  k += "channels=" + channels + "\n";
+  k += std::string("format=") + format_name(format) + "\n";
+  k += std::string("coords=") + (opts.coords ? "1" : "0") + "\n";
+  return k;
+}
+
+ResultCache::ResultCache(std::string dir, std::uint64_t max_bytes)
+    : dir_(std::move(dir)), max_bytes_(max_bytes) {}
+
+bool ResultCache::fetch(const std::string &key, const std::string &path) const {
+  const fs::path entry = fs::path(dir_) / hex(fnv1a64(key));
+  std::ifstream f(entry / "key", std::ios::binary);
+  if (!f)
+    return false;
+  const std::string stored((std::istreambuf_iterator<char>(f)),
+                           std::istreambuf_iterator<char>());
+  if (stored != key)
+    return false;
+  std::error_code ec;
+  if (!place(entry / "data", path))
+    return false;
+  if (fs::exists(entry / "data.json", ec) &&
+      !place(entry / "data.json", path + ".json"))
+    return false;
+  fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+  return true;
+}
+
+void ResultCache::store(const std::string &key, const std::string &path,
+                        bool sidecar) const {
+  const fs::path root(dir_);
+  const fs::path tmp = root / temp_name();
+  try {
+    fs::create_directories(root);
+    fs::create_directory(tmp);
+    {
+      std::ofstream f(tmp / "key", std::ios::binary);
+      if (!(f << key) || !f.flush())
+        throw std::runtime_error("Failed to write cache key in " +
+                                 tmp.string());
+    }
+    fs::copy_file(path, tmp / "data");
+    if (sidecar)
+      fs::copy_file(path + ".json", tmp / "data.json");
+  } catch (const fs::filesystem_error &e) {
+    std::error_code ec;
+    fs::remove_all(tmp, ec);
+    throw std::runtime_error(std::string("Cache store failed: ") + e.what());
+  } catch (...) {
+    std::error_code ec;
+    fs::remove_all(tmp, ec);
+    throw;
+  }
+  // Renaming onto an existing entry fails: another process stored the same
+  // result first, so ours is dropped.
+  const fs::path entry = root / hex(fnv1a64(key));
+  std::error_code ec;
+  fs::rename(tmp, entry, ec);
+  if (ec) {
+    std::error_code rm;
+    fs::remove_all(tmp, rm);
+    if (!fs::exists(entry, rm))
+      throw std::runtime_error("Cache store failed: cannot rename " +
+                               tmp.string() + ": " + ec.message());
+  }
+  evict();
+}
+
+std::uint64_t ResultCache::size() const {
+  std::uint64_t total = 0;
+  for (const Entry &e : list_entries(dir_, false))
+    total += e.bytes;
+  return total;
+}
+
+void ResultCache::evict() const {
+  std::vector<Entry> entries = list_entries(dir_, true);
+  std::uint64_t total = 0;
+  for (const Entry &e : entries)
+    total += e.bytes;
+  if (total <= max_bytes_)
+    return;
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &a, const Entry &b) { return a.used < b.used; });
+  for (const Entry &e : entries) {
+    if (total <= max_bytes_)
+      break;
+    // Move the entry out of reach first, so that no reader links half of
+    // it; a concurrent evictor that got there first makes this fail.
+    const fs::path doomed = fs::path(dir_) / temp_name();
+    std::error_code ec;
+    fs::rename(e.path, doomed, ec);
+    if (!ec)
+      fs::remove_all(doomed, ec);
+    total -= e.bytes;
+  }
+}
+
+} // namespace mandel
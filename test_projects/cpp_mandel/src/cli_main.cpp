@@ -1,8 +1,23 @@
+#include "mandel/cache.hpp"
 #include "mandel/core.hpp"
+#include "mandel/kernels.hpp"
+#include "mandel/parallel.hpp"
+#include "mandel/perf.hpp"
+#include "mandel/perturbation.hpp"
+#include "mandel/precision.hpp"
+#include "mandel/stats.hpp"
+#include "mandel/trace.hpp"
 
+#include <algorithm>
 #include <cctype> // tolower
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -20,10 +35,30 @@ using std::string_view;
 namespace {
 
 struct ArgSpec {
-  string out_path = "mandelbrot.csv";
+  string out_path; // empty: mandelbrot.<format>
   mandel::Params p;
+  string kernel = "auto";
+  string interior = "exact";
+  string format = "csv";
+  string engine = "grid";
+  string fill = "exact";
+  string precision = "double";
+  string schedule = "steal";
+  string channels = "x,y";
+  bool coords = false;
+  mandel::OutputFormat output = mandel::OutputFormat::csv;
   bool show_help = false;
   std::optional<string> config_path{};
+  std::optional<string> batch_path{};
+  string series_report; // empty: none
+  string stats_path;    // empty: no --stats report
+  bool perf = false;    // hardware counters in the --stats report
+  string trace_path;    // empty: no --trace timeline
+  string cache_dir;     // empty: no cache
+  string prev_path;     // empty: compute every pixel
+  int frames = 0;       // > 0: a zoom sequence, out_path is a pattern
+  double zoom_factor = 1.0;
+  double cache_max_mb = 1024.0;
 };
 
 bool starts_with(string_view s, string_view prefix) {
@@ -38,7 +73,7 @@ std::optional<string_view> value_for(string_view arg, string_view name) {
 }
 
 void print_help(const char *argv0) {
-  std::cout << "mandel_cli - minimal Mandelbrot CSV generator\n\n"
+  std::cout << "mandel_cli - minimal Mandelbrot grid generator\n\n"
                "Usage:\n"
                "  "
             << argv0
@@ -46,12 +81,118 @@ void print_help(const char *argv0) {
                "                 [--width N] [--height N]\n"
                "                 [--center-x X] [--center-y Y]\n"
                "                 [--scale S] [--max-iters N]\n"
-               "                 [--out PATH]\n\n"
+               "                 [--threads N] [--schedule S]\n"
+               "                 [--kernel K] [--unroll K]\n"
+               "                 [--interior MODE] [--cycle-tol T]\n"
+               "                 [--engine E] [--fill F] [--precision P]\n"
+               "                 [--series-order K] [--series-tol T]\n"
+               "                 [--series-report tiles.csv]\n"
+               "                 [--stats stats.json] [--perf]\n"
+               "                 [--trace trace.json]\n"
+               "                 [--format F] [--channels LIST] [--coords]\n"
+               "                 [--no-symmetry]\n"
+               "                 [--cache-dir DIR] [--cache-max-mb N]\n"
+               "                 [--prev PREV.raw]\n"
+               "                 [--frames N] [--zoom-factor F]\n"
+               "                 [--out PATH] [--batch variants.jsonl]\n\n"
                "Notes:\n"
-               "  Config values provide defaults; CLI flags override them.\n\n"
+               "  Config values provide defaults; CLI flags override them.\n"
+               "  --threads 0 uses every hardware thread; output does not\n"
+               "  depend on the thread count.\n"
+               "  --schedule spreads tiles over the threads: rows (one\n"
+               "  static block of rows each), steal (idle threads take\n"
+               "  tiles from busy ones) or cost (a 1/16-pixel pre-pass\n"
+               "  estimates each tile's iterations; costliest first).\n"
+               "  --kernel is auto, scalar, avx2 or avx512; auto picks the\n"
+               "  widest one this CPU supports. All give identical output.\n"
+               "  --unroll K (1, 2, 4, 8 or 16) makes the scalar kernel test\n"
+               "  for escape once every K iterations (identical output).\n"
+               "  --interior handles points inside the main cardioid and the\n"
+               "  period-2 bulb: iterate (no test), exact (no bailout tests,\n"
+               "  identical output) or attractor (closed-form limit of z;\n"
+               "  fastest, approximates z at max-iters).\n"
+               "  --cycle-tol enables periodicity checking: 0 stops on exact\n"
+               "  repeats (identical output), T > 0 on |dz| <= T per\n"
+               "  component (approximate), negative disables it.\n"
+               "  --engine subdivide fills rectangles whose border never\n"
+               "  escapes (Mariani-Silver); --fill exact keeps the output\n"
+               "  identical to grid, approximate copies z from the border.\n"
+               "  --engine perturbation is for deep zooms (scale below\n"
+               "  ~1e-13): it iterates a double-double reference orbit at\n"
+               "  the center and double deltas per pixel. Centers keep all\n"
+               "  their digits on the CLI and when quoted in configs.\n"
+               "  --precision is float, double, dd (double-double) or qd\n"
+               "  (quad-double), for --engine grid; auto picks the cheapest\n"
+               "  one that resolves adjacent pixels at --scale. Output is\n"
+               "  double either way; only double honors --interior and\n"
+               "  --cycle-tol, and float is a preview (differs from double).\n"
+               "  --series-order K > 0 lets perturbation skip the first\n"
+               "  iterations of each tile with an order-K series in dc,\n"
+               "  while the first dropped term stays below T times the\n"
+               "  linear one (approximate). --series-report writes the\n"
+               "  iterations skipped per tile as CSV.\n"
+               "  --format is csv, npy (float64 array of shape (C, H, W),\n"
+               "  one plane per channel) or raw (headerless columns plus a\n"
+               "  PATH.json sidecar); --coords adds int32 px/py columns to\n"
+               "  raw output.\n"
+               "  --channels lists the output columns in order, from x and\n"
+               "  y (final z, float64), it (iterations run, uint32),\n"
+               "  escaped (0/1, uint8) and smooth (continuous iteration\n"
+               "  count, float64); e.g. it,x,y,smooth. Channels that are\n"
+               "  not listed are not computed. npy stores all as float64.\n"
+               "  Rows that are exact complex conjugates of earlier rows\n"
+               "  (center-y 0) are mirrored rather than computed, with\n"
+               "  identical output; --no-symmetry computes every row.\n"
+               "  --cache-dir keeps each output in DIR, keyed by a hash of\n"
+               "  the options that determine its bytes; a repeated run\n"
+               "  hardlinks (or copies) the stored file to --out instead of\n"
+               "  computing it. Concurrent runs may share DIR. The least\n"
+               "  recently used outputs are dropped beyond --cache-max-mb.\n"
+               "  Runs with --series-report bypass the cache.\n"
+               "  --prev takes an earlier raw output (with its sidecar and\n"
+               "  x, y columns) of a view at the same scale and settings,\n"
+               "  and copies the pixels whose c it already holds instead of\n"
+               "  computing them (identical output); views that do not line\n"
+               "  up to a whole pixel are computed in full.\n"
+               "  --frames N renders a zoom sequence in one process: frame\n"
+               "  k (from 0) has scale S / F^k for --zoom-factor F, so\n"
+               "  F > 1 zooms in. --out is then a name pattern with a\n"
+               "  printf-style frame number, e.g. frame_%04d.npy. The next\n"
+               "  frame is computed while the previous one is written.\n"
+               "  --stats writes a JSON report of wall and CPU time per\n"
+               "  phase (config, read, compute, write, cache), pixels and\n"
+               "  iterations per second, bytes written, peak RSS and the\n"
+               "  thread count, totalled over every grid of the run.\n"
+               "  --perf adds hardware counters per phase to it (cycles,\n"
+               "  instructions, IPC, branch and cache misses; Linux\n"
+               "  perf_event_open, left out with a reason if refused).\n"
+               "  --trace writes a Chrome Trace Event timeline of every\n"
+               "  tile, band flush and idle wait per thread, for\n"
+               "  ui.perfetto.dev or chrome://tracing.\n"
+               "  --batch runs one grid per line of a JSONL file; each line\n"
+               "  is a JSON config object with an \"out\" path, applied on\n"
+               "  top of the other options. Failed lines are reported and\n"
+               "  skipped (exit status 1).\n\n"
                "Defaults:\n"
                "  --width 300  --height 200  --center-x -0.75  --center-y 0.0\n"
-               "  --scale 0.003  --max-iters 200  --out mandelbrot.csv\n";
+               "  --scale 0.003  --max-iters 200  --threads 1\n"
+               "  --schedule steal\n"
+               "  --kernel auto  --unroll 1  --interior exact  --cycle-tol -1\n"
+               "  --engine grid  --fill exact  --precision double\n"
+               "  --series-order 0  --series-tol 1e-12\n"
+               "  --format csv  --channels x,y  --out mandelbrot.<format>\n"
+               "  --cache-max-mb 1024  --zoom-factor 1\n"
+               "  --out mandelbrot_%04d.<format> with --frames\n";
+}
+
+double parse_double(string_view sv, const char *name);
+
+// Centers keep their decimal text as well, so that Engine::perturbation can
+// parse every digit given as a string; numbers clear it.
+void set_center_text(const string &text, const char *name, double &value,
+                     string &value_text) {
+  value = parse_double(text, name);
+  value_text = text;
 }
 
 // ---------- JSON helpers ----------
@@ -63,15 +204,42 @@ void maybe_set2(const nlohmann::json &j, const char *k1, const char *k2,
   else if (j.contains(k2))
     dst = j.at(k2).get<T>();
 }
+void json_set_center(const nlohmann::json &j, const char *k1, const char *k2,
+                     double &value, string &text) {
+  const char *k = j.contains(k1) ? k1 : j.contains(k2) ? k2 : nullptr;
+  if (!k)
+    return;
+  if (j.at(k).is_string()) {
+    set_center_text(j.at(k).get<string>(), k, value, text);
+  } else {
+    value = j.at(k).get<double>();
+    text.clear();
+  }
+}
 void apply_json_config(const nlohmann::json &j, ArgSpec &a) {
   if (!j.is_object())
     throw std::runtime_error("Config root must be a JSON object");
   maybe_set2(j, "width", "width", a.p.width);
   maybe_set2(j, "height", "height", a.p.height);
-  maybe_set2(j, "center_x", "center-x", a.p.center_x);
-  maybe_set2(j, "center_y", "center-y", a.p.center_y);
+  json_set_center(j, "center_x", "center-x", a.p.center_x, a.p.center_x_text);
+  json_set_center(j, "center_y", "center-y", a.p.center_y, a.p.center_y_text);
   maybe_set2(j, "scale", "scale", a.p.scale);
   maybe_set2(j, "max_iters", "max-iters", a.p.max_iters);
+  maybe_set2(j, "threads", "threads", a.p.threads);
+  maybe_set2(j, "kernel", "kernel", a.kernel);
+  maybe_set2(j, "unroll", "unroll", a.p.unroll);
+  maybe_set2(j, "interior", "interior", a.interior);
+  maybe_set2(j, "cycle_tol", "cycle-tol", a.p.cycle_tol);
+  maybe_set2(j, "format", "format", a.format);
+  maybe_set2(j, "channels", "channels", a.channels);
+  maybe_set2(j, "engine", "engine", a.engine);
+  maybe_set2(j, "fill", "fill", a.fill);
+  maybe_set2(j, "precision", "precision", a.precision);
+  maybe_set2(j, "schedule", "schedule", a.schedule);
+  maybe_set2(j, "series_order", "series-order", a.p.series_order);
+  maybe_set2(j, "series_tol", "series-tol", a.p.series_tol);
+  maybe_set2(j, "frames", "frames", a.frames);
+  maybe_set2(j, "zoom_factor", "zoom-factor", a.zoom_factor);
   if (j.contains("out"))
     a.out_path = j.at("out").get<string>();
 }
@@ -93,13 +261,42 @@ void toml_maybe_set2(const toml::table &t, const char *k1, const char *k2,
   else if (auto v2 = t[k2].template value<T>())
     dst = *v2;
 }
+void toml_set_center(const toml::table &t, const char *k1, const char *k2,
+                     double &value, string &text) {
+  for (const char *k : {k1, k2}) {
+    if (auto s = t[k].value<string>()) {
+      set_center_text(*s, k, value, text);
+      return;
+    }
+    if (auto d = t[k].value<double>()) {
+      value = *d;
+      text.clear();
+      return;
+    }
+  }
+}
 void apply_toml_config(const toml::table &t, ArgSpec &a) {
   toml_maybe_set2(t, "width", "width", a.p.width);
   toml_maybe_set2(t, "height", "height", a.p.height);
-  toml_maybe_set2(t, "center_x", "center-x", a.p.center_x);
-  toml_maybe_set2(t, "center_y", "center-y", a.p.center_y);
+  toml_set_center(t, "center_x", "center-x", a.p.center_x, a.p.center_x_text);
+  toml_set_center(t, "center_y", "center-y", a.p.center_y, a.p.center_y_text);
   toml_maybe_set2(t, "scale", "scale", a.p.scale);
   toml_maybe_set2(t, "max_iters", "max-iters", a.p.max_iters);
+  toml_maybe_set2(t, "threads", "threads", a.p.threads);
+  toml_maybe_set2(t, "kernel", "kernel", a.kernel);
+  toml_maybe_set2(t, "unroll", "unroll", a.p.unroll);
+  toml_maybe_set2(t, "interior", "interior", a.interior);
+  toml_maybe_set2(t, "cycle_tol", "cycle-tol", a.p.cycle_tol);
+  toml_maybe_set2(t, "format", "format", a.format);
+  toml_maybe_set2(t, "channels", "channels", a.channels);
+  toml_maybe_set2(t, "engine", "engine", a.engine);
+  toml_maybe_set2(t, "fill", "fill", a.fill);
+  toml_maybe_set2(t, "precision", "precision", a.precision);
+  toml_maybe_set2(t, "schedule", "schedule", a.schedule);
+  toml_maybe_set2(t, "series_order", "series-order", a.p.series_order);
+  toml_maybe_set2(t, "series_tol", "series-tol", a.p.series_tol);
+  toml_maybe_set2(t, "frames", "frames", a.frames);
+  toml_maybe_set2(t, "zoom_factor", "zoom-factor", a.zoom_factor);
   if (auto v = t["out"].value<string>())
     a.out_path = *v;
 }
@@ -120,15 +317,38 @@ void yaml_maybe_set2(const YAML::Node &n, const char *k1, const char *k2,
   else if (auto v2 = n[k2])
     dst = v2.as<T>();
 }
+// YAML scalars keep their source text, quoted or not.
+void yaml_set_center(const YAML::Node &n, const char *k1, const char *k2,
+                     double &value, string &text) {
+  if (auto v = n[k1])
+    set_center_text(v.as<string>(), k1, value, text);
+  else if (auto v2 = n[k2])
+    set_center_text(v2.as<string>(), k2, value, text);
+}
 void apply_yaml_config(const YAML::Node &n, ArgSpec &a) {
   if (!n || !n.IsMap())
     throw std::runtime_error("YAML config root must be a mapping/object");
   yaml_maybe_set2(n, "width", "width", a.p.width);
   yaml_maybe_set2(n, "height", "height", a.p.height);
-  yaml_maybe_set2(n, "center_x", "center-x", a.p.center_x);
-  yaml_maybe_set2(n, "center_y", "center-y", a.p.center_y);
+  yaml_set_center(n, "center_x", "center-x", a.p.center_x, a.p.center_x_text);
+  yaml_set_center(n, "center_y", "center-y", a.p.center_y, a.p.center_y_text);
   yaml_maybe_set2(n, "scale", "scale", a.p.scale);
   yaml_maybe_set2(n, "max_iters", "max-iters", a.p.max_iters);
+  yaml_maybe_set2(n, "threads", "threads", a.p.threads);
+  yaml_maybe_set2(n, "kernel", "kernel", a.kernel);
+  yaml_maybe_set2(n, "unroll", "unroll", a.p.unroll);
+  yaml_maybe_set2(n, "interior", "interior", a.interior);
+  yaml_maybe_set2(n, "cycle_tol", "cycle-tol", a.p.cycle_tol);
+  yaml_maybe_set2(n, "format", "format", a.format);
+  yaml_maybe_set2(n, "channels", "channels", a.channels);
+  yaml_maybe_set2(n, "engine", "engine", a.engine);
+  yaml_maybe_set2(n, "fill", "fill", a.fill);
+  yaml_maybe_set2(n, "precision", "precision", a.precision);
+  yaml_maybe_set2(n, "schedule", "schedule", a.schedule);
+  yaml_maybe_set2(n, "series_order", "series-order", a.p.series_order);
+  yaml_maybe_set2(n, "series_tol", "series-tol", a.p.series_tol);
+  yaml_maybe_set2(n, "frames", "frames", a.frames);
+  yaml_maybe_set2(n, "zoom_factor", "zoom-factor", a.zoom_factor);
   if (auto v = n["out"])
     a.out_path = v.as<string>();
 }
@@ -201,15 +421,40 @@ void xml_maybe_set2(const pugi::xml_node &root, const char *k1, const char *k2,
     return;
   }
 }
+void xml_set_center(const pugi::xml_node &root, const char *k1,
+                    const char *k2, double &value, string &text) {
+  string tmp;
+  if (xml_get(root, k1, tmp))
+    set_center_text(tmp, k1, value, text);
+  else if (xml_get(root, k2, tmp))
+    set_center_text(tmp, k2, value, text);
+}
 void apply_xml_config(const pugi::xml_node &root, ArgSpec &a) {
   // Accept either attributes on root or child elements:
   // <config width="320" .../>  OR  <config><width>320</width>...</config>
   xml_maybe_set2(root, "width", "width", a.p.width);
   xml_maybe_set2(root, "height", "height", a.p.height);
-  xml_maybe_set2(root, "center_x", "center-x", a.p.center_x);
-  xml_maybe_set2(root, "center_y", "center-y", a.p.center_y);
+  xml_set_center(root, "center_x", "center-x", a.p.center_x,
+                 a.p.center_x_text);
+  xml_set_center(root, "center_y", "center-y", a.p.center_y,
+                 a.p.center_y_text);
   xml_maybe_set2(root, "scale", "scale", a.p.scale);
   xml_maybe_set2(root, "max_iters", "max-iters", a.p.max_iters);
+  xml_maybe_set2(root, "threads", "threads", a.p.threads);
+  xml_maybe_set2(root, "kernel", "kernel", a.kernel);
+  xml_maybe_set2(root, "unroll", "unroll", a.p.unroll);
+  xml_maybe_set2(root, "interior", "interior", a.interior);
+  xml_maybe_set2(root, "cycle_tol", "cycle-tol", a.p.cycle_tol);
+  xml_maybe_set2(root, "format", "format", a.format);
+  xml_maybe_set2(root, "channels", "channels", a.channels);
+  xml_maybe_set2(root, "engine", "engine", a.engine);
+  xml_maybe_set2(root, "fill", "fill", a.fill);
+  xml_maybe_set2(root, "precision", "precision", a.precision);
+  xml_maybe_set2(root, "schedule", "schedule", a.schedule);
+  xml_maybe_set2(root, "series_order", "series-order", a.p.series_order);
+  xml_maybe_set2(root, "series_tol", "series-tol", a.p.series_tol);
+  xml_maybe_set2(root, "frames", "frames", a.frames);
+  xml_maybe_set2(root, "zoom_factor", "zoom-factor", a.zoom_factor);
   xml_maybe_set2(root, "out", "out", a.out_path);
 }
 
@@ -311,11 +556,13 @@ ArgSpec parse_args(int argc, char **argv) {
                   [&](string_view v) { a.p.height = parse_int(v, "height"); }))
       continue;
     if (parse_opt("--center-x", [&](string_view v) {
-          a.p.center_x = parse_double(v, "center-x");
+          set_center_text(string(v), "center-x", a.p.center_x,
+                          a.p.center_x_text);
         }))
       continue;
     if (parse_opt("--center-y", [&](string_view v) {
-          a.p.center_y = parse_double(v, "center-y");
+          set_center_text(string(v), "center-y", a.p.center_y,
+                          a.p.center_y_text);
         }))
       continue;
     if (parse_opt("--scale",
@@ -325,34 +572,794 @@ ArgSpec parse_args(int argc, char **argv) {
           a.p.max_iters = parse_int(v, "max-iters");
         }))
       continue;
+    if (parse_opt("--threads", [&](string_view v) {
+          a.p.threads = parse_int(v, "threads");
+        }))
+      continue;
+    if (parse_opt("--kernel", [&](string_view v) { a.kernel = string(v); }))
+      continue;
+    if (parse_opt("--unroll", [&](string_view v) {
+          a.p.unroll = parse_int(v, "unroll");
+        }))
+      continue;
+    if (parse_opt("--interior",
+                  [&](string_view v) { a.interior = string(v); }))
+      continue;
+    if (parse_opt("--cycle-tol", [&](string_view v) {
+          a.p.cycle_tol = parse_double(v, "cycle-tol");
+        }))
+      continue;
+    if (parse_opt("--format", [&](string_view v) { a.format = string(v); }))
+      continue;
+    if (parse_opt("--cache-dir",
+                  [&](string_view v) { a.cache_dir = string(v); }))
+      continue;
+    if (parse_opt("--prev",
+                  [&](string_view v) { a.prev_path = string(v); }))
+      continue;
+    if (parse_opt("--frames", [&](string_view v) {
+          a.frames = parse_int(v, "frames");
+        }))
+      continue;
+    if (parse_opt("--zoom-factor", [&](string_view v) {
+          a.zoom_factor = parse_double(v, "zoom-factor");
+        }))
+      continue;
+    if (parse_opt("--cache-max-mb", [&](string_view v) {
+          a.cache_max_mb = parse_double(v, "cache-max-mb");
+        }))
+      continue;
+    if (parse_opt("--channels",
+                  [&](string_view v) { a.channels = string(v); }))
+      continue;
+    if (parse_opt("--engine", [&](string_view v) { a.engine = string(v); }))
+      continue;
+    if (parse_opt("--fill", [&](string_view v) { a.fill = string(v); }))
+      continue;
+    if (parse_opt("--precision",
+                  [&](string_view v) { a.precision = string(v); }))
+      continue;
+    if (parse_opt("--schedule",
+                  [&](string_view v) { a.schedule = string(v); }))
+      continue;
+    if (parse_opt("--series-order", [&](string_view v) {
+          a.p.series_order = parse_int(v, "series-order");
+        }))
+      continue;
+    if (parse_opt("--series-tol", [&](string_view v) {
+          a.p.series_tol = parse_double(v, "series-tol");
+        }))
+      continue;
+    if (parse_opt("--series-report",
+                  [&](string_view v) { a.series_report = string(v); }))
+      continue;
+    if (parse_opt("--stats",
+                  [&](string_view v) { a.stats_path = string(v); }))
+      continue;
+    if (parse_opt("--trace",
+                  [&](string_view v) { a.trace_path = string(v); }))
+      continue;
+    if (cur == "--perf") {
+      a.perf = true;
+      continue;
+    }
+    if (cur == "--coords") {
+      a.coords = true;
+      continue;
+    }
+    if (cur == "--no-symmetry") {
+      a.p.symmetry = false;
+      continue;
+    }
     if (parse_opt("--out", [&](string_view v) { a.out_path = string(v); }))
       continue;
+    if (parse_opt("--batch",
+                  [&](string_view v) { a.batch_path = string(v); }))
+      continue;
 
     throw std::runtime_error("Unknown argument: " + string(cur));
   }
 
+  return a;
+}
+
+// --frames: the view of frame k, zoomed about the center.
+mandel::Params frame_params(const ArgSpec &a, int k) {
+  mandel::Params p = a.p;
+  p.scale = a.p.scale / std::pow(a.zoom_factor, k);
+  return p;
+}
+
+// --frames: pattern with its printf-style frame number (%d, %04d, ...)
+// replaced by frame; %% is a literal %. Throws unless there is exactly one
+// frame number.
+string frame_path(const string &pattern, int frame) {
+  string path;
+  int numbers = 0;
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] != '%') {
+      path += pattern[i];
+      continue;
+    }
+    std::size_t j = i + 1;
+    if (j < pattern.size() && pattern[j] == '%') {
+      path += '%';
+      i = j;
+      continue;
+    }
+    const bool zeros = j < pattern.size() && pattern[j] == '0';
+    std::size_t width = 0;
+    while (j < pattern.size() && pattern[j] >= '0' && pattern[j] <= '9')
+      width = width * 10 + static_cast<std::size_t>(pattern[j++] - '0');
+    if (j == pattern.size() || pattern[j] != 'd' || width > 20)
+      throw std::runtime_error("Bad frame number in --out pattern: " +
+                               pattern + " (expected e.g. %04d)");
+    const string number = std::to_string(frame);
+    if (number.size() < width)
+      path.append(width - number.size(), zeros ? '0' : ' ');
+    path += number;
+    ++numbers;
+    i = j;
+  }
+  if (numbers != 1)
+    throw std::runtime_error("--frames needs one frame number in --out, "
+                             "e.g. frame_%04d.npy: " +
+                             pattern);
+  return path;
+}
+
+// Validate a fully merged ArgSpec and convert its string options.
+void finalize(ArgSpec &a) {
   if (a.p.width <= 0 || a.p.height <= 0)
     throw std::runtime_error("width/height must be positive.");
   if (a.p.max_iters <= 0)
     throw std::runtime_error("max-iters must be positive.");
   if (a.p.scale <= 0.0)
     throw std::runtime_error("scale must be positive.");
-  return a;
+  if (a.p.threads < 0)
+    throw std::runtime_error("threads must be >= 0 (0 = all cores).");
+  a.p.kernel = mandel::parse_kernel(a.kernel);
+  mandel::unrolled_kernel_fn(a.p.unroll); // throws on unsupported factors
+  a.p.interior = mandel::parse_interior(a.interior);
+  a.p.engine = mandel::parse_engine(a.engine);
+  a.p.fill = mandel::parse_fill(a.fill);
+  a.p.precision = mandel::parse_precision(a.precision);
+  a.p.schedule = mandel::parse_schedule(a.schedule);
+  mandel::resolve_precision(a.p); // throws if the engine or scale rule it out
+  if (a.p.engine == mandel::Engine::perturbation)
+    mandel::view_center(a.p); // throws on malformed center text
+  if (a.p.series_order < 0 || a.p.series_order > 64)
+    throw std::runtime_error("series-order must be in 0..64.");
+  if (!(a.p.series_tol > 0.0))
+    throw std::runtime_error("series-tol must be positive.");
+  if (!(a.cache_max_mb >= 0.0))
+    throw std::runtime_error("cache-max-mb must be >= 0.");
+  a.output = mandel::parse_format(a.format);
+  a.p.channels = mandel::parse_channels(a.channels);
+  if (a.frames < 0)
+    throw std::runtime_error("frames must be >= 0.");
+  if (!(a.zoom_factor > 0.0))
+    throw std::runtime_error("zoom-factor must be positive.");
+  if (a.frames > 0) {
+    if (!a.prev_path.empty())
+      throw std::runtime_error("--prev cannot be used with --frames");
+    if (!a.series_report.empty())
+      throw std::runtime_error("--series-report cannot be used with --frames");
+    if (a.out_path.empty())
+      a.out_path =
+          string("mandelbrot_%04d.") + mandel::format_name(a.output);
+    frame_path(a.out_path, 0); // throws on a bad pattern
+    for (int k = 1; k < a.frames; ++k) {
+      const mandel::Params p = frame_params(a, k);
+      if (!(p.scale > 0.0))
+        throw std::runtime_error("scale of frame " + std::to_string(k) +
+                                 " underflows; use fewer frames.");
+      mandel::resolve_precision(p);
+    }
+  }
+  if (a.out_path.empty())
+    a.out_path = string("mandelbrot.") + mandel::format_name(a.output);
+}
+
+// --series-report: one CSV row per computed tile, in row-major tile order.
+void write_series_report(const string &path,
+                         std::vector<mandel::TileReport> &tiles) {
+  std::sort(tiles.begin(), tiles.end(),
+            [](const mandel::TileReport &a, const mandel::TileReport &b) {
+              return a.y0 != b.y0 ? a.y0 < b.y0 : a.x0 < b.x0;
+            });
+  std::ofstream f(path);
+  if (!f)
+    throw std::runtime_error("Failed to open series report: " + path);
+  f << "x0,y0,x1,y1,skipped\n";
+  for (const auto &t : tiles)
+    f << t.x0 << ',' << t.y0 << ',' << t.x1 << ',' << t.y1 << ','
+      << t.series_skipped << '\n';
+  if (!f.flush())
+    throw std::runtime_error("I/O error while writing series report: " +
+                             path);
+}
+
+// --prev: an earlier raw output, read back through its sidecar.
+struct Prev {
+  mandel::Params p;
+  mandel::GridResult grid;
+};
+
+Prev load_prev(const string &path) {
+  // Checked here, or a missing sidecar reads as a config error.
+  if (!std::filesystem::is_regular_file(path + ".json"))
+    throw std::runtime_error("--prev needs raw output with a sidecar: " +
+                             path);
+  const nlohmann::json side = load_json_file(path + ".json");
+  if (side.value("format", "") != "mandel-raw")
+    throw std::runtime_error("--prev needs raw output with a sidecar: " +
+                             path);
+  Prev prev;
+  prev.p.width = side.at("width").get<int>();
+  prev.p.height = side.at("height").get<int>();
+  const auto &params = side.at("params");
+  if (!params.contains("engine"))
+    throw std::runtime_error("--prev: " + path +
+                             ".json predates the engine settings; "
+                             "regenerate it");
+  prev.p.center_x = params.at("center_x").get<double>();
+  prev.p.center_y = params.at("center_y").get<double>();
+  prev.p.scale = params.at("scale").get<double>();
+  prev.p.max_iters = params.at("max_iters").get<int>();
+  prev.p.precision =
+      mandel::parse_precision(params.at("precision").get<string>());
+  prev.p.engine = mandel::parse_engine(params.at("engine").get<string>());
+  prev.p.fill = mandel::parse_fill(params.at("fill").get<string>());
+  prev.p.interior =
+      mandel::parse_interior(params.at("interior").get<string>());
+  prev.p.cycle_tol = params.at("cycle_tol").get<double>();
+
+  struct Column {
+    mandel::Channel channel;
+    std::uint64_t offset;
+  };
+  std::vector<Column> columns;
+  prev.p.channels.clear();
+  for (const auto &c : side.at("columns")) {
+    const string name = c.at("name").get<string>();
+    if (name == "px" || name == "py")
+      continue;
+    const mandel::Channel ch = mandel::parse_channels(name).front();
+    const string dtype = c.at("dtype").get<string>();
+    const char *want = ch == mandel::Channel::iterations ? "<u4"
+                       : ch == mandel::Channel::escaped  ? "|u1"
+                                                         : "<f8";
+    if (dtype != want)
+      throw std::runtime_error("--prev: unexpected dtype " + dtype +
+                               " for column " + name);
+    columns.push_back({ch, c.at("offset").get<std::uint64_t>()});
+    prev.p.channels.push_back(ch);
+  }
+  // A grid with smooth also holds iteration counts; without them in the
+  // file, the smooth column cannot be used.
+  if (!mandel::has_channel(prev.p.channels, mandel::Channel::iterations)) {
+    std::erase_if(columns, [](const Column &c) {
+      return c.channel == mandel::Channel::smooth;
+    });
+    std::erase(prev.p.channels, mandel::Channel::smooth);
+  }
+  prev.grid.resize(prev.p.width, prev.p.height, prev.p.channels);
+  std::ifstream f(path, std::ios::binary);
+  if (!f)
+    throw std::runtime_error("Failed to open --prev: " + path);
+  const std::size_t n = prev.grid.size();
+  bool have_x = false, have_y = false;
+  for (const Column &c : columns) {
+    auto read = [&](auto *dst) {
+      f.seekg(static_cast<std::streamoff>(c.offset));
+      f.read(reinterpret_cast<char *>(dst),
+             static_cast<std::streamsize>(n * sizeof *dst));
+      if (!f)
+        throw std::runtime_error("--prev: " + path + " is truncated");
+    };
+    switch (c.channel) {
+    case mandel::Channel::x:
+      read(prev.grid.x());
+      have_x = true;
+      break;
+    case mandel::Channel::y:
+      read(prev.grid.y());
+      have_y = true;
+      break;
+    case mandel::Channel::iterations:
+      read(prev.grid.iterations());
+      break;
+    case mandel::Channel::escaped:
+      read(prev.grid.escaped());
+      break;
+    case mandel::Channel::smooth:
+      read(prev.grid.smooth());
+      break;
+    }
+  }
+  if (!have_x || !have_y)
+    throw std::runtime_error("--prev: " + path + " has no x and y columns");
+  return prev;
+}
+
+// --stats: totals over every grid of the process. While rows stream,
+// compute and write overlap: write is the time the main thread spends in
+// the writer, compute the rest (CPU time of the workers included).
+struct RunStats {
+  mandel::PhaseTime config; // parsing options and config files
+  mandel::PhaseTime read;   // loading --prev
+  mandel::PhaseTime compute;
+  mandel::PhaseTime write;
+  mandel::PhaseTime cache; // --cache-dir lookups and stores
+  int threads = 0;
+  std::uint64_t grids = 0; // computed, i.e. not served from the cache
+  std::uint64_t cache_hits = 0;
+  std::uint64_t pixels = 0;
+  // Sum of the per-pixel iteration counts of the computed grids; unknown
+  // once a grid could not count them (--prev without an it column).
+  std::uint64_t iterations = 0;
+  bool iterations_known = true;
+  std::uint64_t bytes = 0; // output files, sidecars included
+  // --perf: counters of the whole process and of the main thread.
+  const mandel::PerfCounters *process_perf = nullptr;
+  const mandel::PerfCounters *thread_perf = nullptr;
+};
+
+// Adds the time until the end of its scope to one phase of *stats; does
+// nothing (and reads no clock) when stats is null.
+class PhaseScope {
+public:
+  PhaseScope(RunStats *stats, mandel::PhaseTime RunStats::*phase)
+      : stats_(stats), phase_(phase) {
+    if (stats_)
+      watch_.emplace(mandel::Stopwatch::Cpu::process, stats_->process_perf);
+  }
+  PhaseScope(const PhaseScope &) = delete;
+  PhaseScope &operator=(const PhaseScope &) = delete;
+  ~PhaseScope() {
+    if (stats_)
+      stats_->*phase_ += watch_->elapsed();
+  }
+
+private:
+  RunStats *stats_;
+  mandel::PhaseTime RunStats::*phase_;
+  std::optional<mandel::Stopwatch> watch_;
+};
+
+void write_stats(const string &path, const RunStats &s,
+                 mandel::PhaseTime total) {
+  const mandel::PerfCounters *perf = s.process_perf;
+  if (perf)
+    total.perf = perf->read(); // counted since they were opened
+  auto counters = [&](const mandel::PerfSample &c) {
+    nlohmann::json j;
+    for (std::size_t i = 0; i < mandel::kPerfEvents; ++i) {
+      const auto e = static_cast<mandel::PerfEvent>(i);
+      j[mandel::perf_event_name(e)] =
+          perf->has(e) ? nlohmann::json(c[e]) : nlohmann::json(nullptr);
+    }
+    const bool ipc = perf->has(mandel::PerfEvent::cycles) &&
+                     perf->has(mandel::PerfEvent::instructions) &&
+                     c[mandel::PerfEvent::cycles] > 0;
+    j["ipc"] = ipc ? nlohmann::json(
+                         static_cast<double>(
+                             c[mandel::PerfEvent::instructions]) /
+                         static_cast<double>(c[mandel::PerfEvent::cycles]))
+                   : nlohmann::json(nullptr);
+    return j;
+  };
+  auto phase = [&](const mandel::PhaseTime &t, bool counted = true) {
+    nlohmann::json j{{"wall_s", t.wall}, {"cpu_s", t.cpu}};
+    if (perf && counted)
+      j["counters"] = counters(t.perf);
+    return j;
+  };
+  // Rates over phases that took no measurable time are null.
+  auto rate = [](double amount, double seconds) {
+    return seconds > 0.0 ? nlohmann::json(amount / seconds)
+                         : nlohmann::json(nullptr);
+  };
+  nlohmann::json j;
+  j["threads"] = s.threads;
+  j["grids"] = s.grids;
+  j["cache_hits"] = s.cache_hits;
+  j["pixels"] = s.pixels;
+  j["iterations"] = s.iterations_known ? nlohmann::json(s.iterations)
+                                       : nlohmann::json(nullptr);
+  j["bytes_written"] = s.bytes;
+  j["total"] = phase(total);
+  // The counters are opened after the options are parsed.
+  j["phases"] = {{"config", phase(s.config, false)},
+                 {"read", phase(s.read)},
+                 {"compute", phase(s.compute)}, {"write", phase(s.write)},
+                 {"cache", phase(s.cache)}};
+  const double pixels = static_cast<double>(s.pixels);
+  j["pixels_per_s"] = rate(pixels, s.compute.wall);
+  j["iterations_per_s"] =
+      s.iterations_known
+          ? rate(static_cast<double>(s.iterations), s.compute.wall)
+          : nlohmann::json(nullptr);
+  j["write_mb_per_s"] =
+      rate(static_cast<double>(s.bytes) / 1e6, s.write.wall);
+  j["peak_rss_bytes"] = mandel::peak_rss_bytes();
+  if (perf) {
+    nlohmann::json events = nlohmann::json::array();
+    for (std::size_t i = 0; i < mandel::kPerfEvents; ++i) {
+      const auto e = static_cast<mandel::PerfEvent>(i);
+      if (perf->has(e))
+        events.push_back(mandel::perf_event_name(e));
+    }
+    j["perf"] = {{"available", perf->available()}, {"events", events}};
+    if (!perf->reason().empty())
+      j["perf"]["reason"] = perf->reason();
+  }
+  std::ofstream f(path);
+  if (!f || !(f << j.dump(2) << '\n') || !f.flush())
+    throw std::runtime_error("Failed to write stats: " + path);
+}
+
+// Adds Channel::iterations to p, so that --stats can count iterations.
+void count_iterations(mandel::Params &p) {
+  if (!mandel::has_channel(p.channels, mandel::Channel::iterations))
+    p.channels.push_back(mandel::Channel::iterations);
+}
+
+// Size of an output file plus its raw sidecar.
+std::uint64_t output_bytes(const ArgSpec &a, const string &path) {
+  std::error_code ec;
+  std::uint64_t n = std::filesystem::file_size(path, ec);
+  if (ec)
+    n = 0;
+  if (a.output == mandel::OutputFormat::raw) {
+    const std::uint64_t side = std::filesystem::file_size(path + ".json", ec);
+    if (!ec)
+      n += side;
+  }
+  return n;
+}
+
+// Reused across the grids of one process: the thread pool and one writer
+// (with its I/O buffers) per output format.
+class Runner {
+public:
+  // stats: accumulates --stats totals; tracer: records --trace spans. Both
+  // are null when off.
+  explicit Runner(RunStats *stats = nullptr, mandel::Tracer *tracer = nullptr)
+      : stats_(stats), tracer_(tracer) {}
+
+  void run(const ArgSpec &a) {
+    const int threads = mandel::resolve_threads(a.p.threads);
+    if (!pool_ || pool_->size() != threads)
+      pool_ = std::make_unique<mandel::ThreadPool>(threads, tracer_);
+    if (stats_)
+      stats_->threads = threads;
+    if (a.frames > 0) {
+      run_frames(a);
+      return;
+    }
+    const bool cached = !a.cache_dir.empty() && a.series_report.empty();
+    std::optional<mandel::ResultCache> cache;
+    string key;
+    if (cached) {
+      cache.emplace(a.cache_dir, static_cast<std::uint64_t>(
+                                     a.cache_max_mb * 1024.0 * 1024.0));
+      key = mandel::cache_key(a.p, a.output, writer_options(a));
+      if (fetch(*cache, key, a.out_path))
+        return;
+    }
+    mandel::Params p = a.p;
+    std::mutex tiles_mu;
+    std::vector<mandel::TileReport> tiles;
+    if (!a.series_report.empty()) {
+      p.on_tile = [&](const mandel::TileReport &t) {
+        std::lock_guard<std::mutex> lock(tiles_mu);
+        tiles.push_back(t);
+      };
+    }
+    // The writer takes p; with --stats the grid also counts iterations.
+    mandel::Params cp = p;
+    if (!a.prev_path.empty()) {
+      std::optional<Prev> prev;
+      {
+        PhaseScope t(stats_, &RunStats::read);
+        prev.emplace(load_prev(a.prev_path));
+      }
+      // Counting must not rule out reuse of a grid without counts.
+      if (stats_ && !mandel::has_channel(cp.channels,
+                                         mandel::Channel::iterations)) {
+        if (mandel::has_channel(prev->p.channels,
+                                mandel::Channel::iterations))
+          count_iterations(cp);
+        else
+          stats_->iterations_known = false;
+      }
+      mandel::GridResult g;
+      {
+        PhaseScope t(stats_, &RunStats::compute);
+        mandel::compute_grid_incremental(prev->p, prev->grid, cp, g, *pool_);
+      }
+      tally(g.view());
+      PhaseScope t(stats_, &RunStats::write);
+      mandel::GridWriter &writer = writer_for(a, a.out_path);
+      writer.begin(p);
+      write_rows(writer, g.view(), 0);
+      finish(writer, 0);
+    } else {
+      if (stats_)
+        count_iterations(cp);
+      mandel::GridWriter &writer = writer_for(a, a.out_path);
+      mandel::PhaseTime written;
+      {
+        PhaseScope t(stats_, &RunStats::compute);
+        timed(written, [&] { writer.begin(p); });
+        mandel::compute_grid_streaming(
+            cp,
+            [&](const mandel::GridView &rows) {
+              tally(rows);
+              timed(written, [&] { write_rows(writer, rows, 0); });
+            },
+            *pool_);
+        timed(written, [&] { finish(writer, 0); });
+      }
+      if (stats_) {
+        stats_->compute -= written;
+        stats_->write += written;
+      }
+    }
+    if (stats_) {
+      ++stats_->grids;
+      stats_->bytes += output_bytes(a, a.out_path);
+    }
+    if (!a.series_report.empty()) {
+      PhaseScope t(stats_, &RunStats::write);
+      write_series_report(a.series_report, tiles);
+    }
+    if (cached) {
+      PhaseScope t(stats_, &RunStats::cache);
+      store(*cache, key, a.out_path, a);
+    }
+  }
+
+  // Joins the workers, after which the tracer holds every span.
+  void stop() { pool_.reset(); }
+
+private:
+  // --frames: every frame through one compute_frames_streaming() call, so
+  // that computing a frame overlaps writing the one before. Frames found
+  // in the cache are left out.
+  void run_frames(const ArgSpec &a) {
+    std::optional<mandel::ResultCache> cache;
+    if (!a.cache_dir.empty())
+      cache.emplace(a.cache_dir, static_cast<std::uint64_t>(
+                                     a.cache_max_mb * 1024.0 * 1024.0));
+    struct Job {
+      string path;
+      string key;
+    };
+    std::vector<mandel::Params> frames;
+    std::vector<Job> jobs;
+    for (int k = 0; k < a.frames; ++k) {
+      Job job{frame_path(a.out_path, k), {}};
+      mandel::Params p = frame_params(a, k);
+      if (cache) {
+        job.key = mandel::cache_key(p, a.output, writer_options(a));
+        if (fetch(*cache, job.key, job.path))
+          continue;
+      }
+      frames.push_back(std::move(p));
+      jobs.push_back(std::move(job));
+    }
+    // The writer takes frames[k]; with --stats the grids count iterations.
+    std::vector<mandel::Params> counted;
+    if (stats_) {
+      counted = frames;
+      for (mandel::Params &p : counted)
+        count_iterations(p);
+    }
+    mandel::GridWriter *writer = nullptr;
+    mandel::PhaseTime written, stored; // main thread, while workers compute
+    {
+      PhaseScope t(stats_, &RunStats::compute);
+      mandel::compute_frames_streaming(
+          stats_ ? counted : frames,
+          [&](std::size_t k, const mandel::GridView &rows) {
+            const Job &job = jobs[k];
+            tally(rows);
+            if (rows.y0 == 0) {
+              writer = &writer_for(a, job.path);
+              timed(written, [&] { writer->begin(frames[k]); });
+            }
+            timed(written, [&] { write_rows(*writer, rows, k); });
+            if (rows.y0 + rows.rows < frames[k].height)
+              return;
+            timed(written, [&] { finish(*writer, k); });
+            if (stats_) {
+              ++stats_->grids;
+              stats_->bytes += output_bytes(a, job.path);
+            }
+            if (cache)
+              timed(stored, [&] { store(*cache, job.key, job.path, a); });
+          },
+          *pool_);
+    }
+    if (stats_) {
+      stats_->compute -= written;
+      stats_->compute -= stored;
+      stats_->write += written;
+      stats_->cache += stored;
+    }
+  }
+
+  // With --stats: runs fn on the main thread while workers may be busy,
+  // adding its wall time and the main thread's CPU time to t.
+  template <class Fn> void timed(mandel::PhaseTime &t, Fn &&fn) {
+    if (!stats_) {
+      fn();
+      return;
+    }
+    const mandel::Stopwatch watch(mandel::Stopwatch::Cpu::thread,
+                                  stats_->thread_perf);
+    fn();
+    t += watch.elapsed();
+  }
+
+  // w.write(rows), recorded as a --trace flush span of the main thread.
+  void write_rows(mandel::GridWriter &w, const mandel::GridView &rows,
+                  std::size_t frame) {
+    const std::uint64_t t0 = tracer_ ? tracer_->now() : 0;
+    w.write(rows);
+    if (tracer_)
+      tracer_->record(0, mandel::TraceKind::flush, t0, tracer_->now(),
+                      {static_cast<int>(frame), rows.y0, rows.rows});
+  }
+
+  // w.finish(): the last buffered rows and any sidecar, traced likewise.
+  void finish(mandel::GridWriter &w, std::size_t frame) {
+    const std::uint64_t t0 = tracer_ ? tracer_->now() : 0;
+    w.finish();
+    if (tracer_)
+      tracer_->record(0, mandel::TraceKind::finish, t0, tracer_->now(),
+                      {static_cast<int>(frame)});
+  }
+
+  // With --stats: counts the pixels and iterations of computed rows.
+  void tally(const mandel::GridView &rows) {
+    if (!stats_)
+      return;
+    stats_->pixels += rows.size();
+    if (rows.iterations)
+      for (std::size_t i = 0; i < rows.size(); ++i)
+        stats_->iterations += rows.iterations[i];
+  }
+
+  bool fetch(const mandel::ResultCache &cache, const string &key,
+             const string &path) {
+    PhaseScope t(stats_, &RunStats::cache);
+    const bool hit = cache.fetch(key, path);
+    if (hit && stats_)
+      ++stats_->cache_hits;
+    return hit;
+  }
+
+  // The output is complete; failing to keep a copy is not an error.
+  static void store(const mandel::ResultCache &cache, const string &key,
+                    const string &path, const ArgSpec &a) {
+    try {
+      cache.store(key, path, a.output == mandel::OutputFormat::raw);
+    } catch (const std::exception &e) {
+      std::cerr << "Warning: " << e.what() << "\n";
+    }
+  }
+
+  static mandel::WriterOptions writer_options(const ArgSpec &a) {
+    mandel::WriterOptions opts;
+    opts.coords = a.coords;
+    return opts;
+  }
+
+  mandel::GridWriter &writer_for(const ArgSpec &a, const string &path) {
+    auto &w = writers_[{a.output, a.coords}];
+    if (w)
+      w->reopen(path);
+    else
+      w = mandel::make_writer(a.output, path, writer_options(a));
+    return *w;
+  }
+
+  RunStats *stats_;
+  mandel::Tracer *tracer_;
+  std::unique_ptr<mandel::ThreadPool> pool_;
+  std::map<std::pair<mandel::OutputFormat, bool>,
+           std::unique_ptr<mandel::GridWriter>>
+      writers_;
+};
+
+// --batch: one variant per line, each a JSON object with the same keys as a
+// JSON config plus "out". Variant keys override --config and CLI values.
+// A failing variant is reported and skipped. Returns the number of failed
+// variants.
+int run_batch(const ArgSpec &base, Runner &runner) {
+  std::ifstream in(*base.batch_path);
+  if (!in)
+    throw std::runtime_error("Failed to open batch file: " + *base.batch_path);
+  int failed = 0;
+  int line_no = 0;
+  string line;
+  while (std::getline(in, line)) {
+    ++line_no;
+    if (line.find_first_not_of(" \t\r") == string::npos)
+      continue;
+    try {
+      const auto j = nlohmann::json::parse(line);
+      if (!j.is_object() || !j.contains("out"))
+        throw std::runtime_error("variant needs an \"out\" path");
+      ArgSpec a = base;
+      apply_json_config(j, a);
+      finalize(a);
+      runner.run(a);
+    } catch (const std::exception &e) {
+      ++failed;
+      std::cerr << *base.batch_path << ":" << line_no << ": " << e.what()
+                << "\n";
+    }
+  }
+  return failed;
 }
 
 } // namespace
 
 int main(int argc, char **argv) {
+  const mandel::Stopwatch process;
   try {
     auto args = parse_args(argc, argv);
     if (args.show_help) {
       print_help(argv[0]);
       return 0;
     }
-
-    std::vector<mandel::PixelResult> data;
-    mandel::compute_grid(args.p, data);
-    mandel::write_csv(args.out_path, data);
+    if (args.perf && args.stats_path.empty())
+      throw std::runtime_error("--perf needs --stats");
+    std::optional<RunStats> stats;
+    if (!args.stats_path.empty())
+      stats.emplace();
+    // Before the Runner starts any worker, so that they are counted too.
+    std::optional<mandel::PerfCounters> process_perf, thread_perf;
+    if (args.perf) {
+      process_perf.emplace(mandel::PerfCounters::Scope::process);
+      thread_perf.emplace(mandel::PerfCounters::Scope::thread);
+      stats->process_perf = &*process_perf;
+      stats->thread_perf = &*thread_perf;
+    }
+    std::optional<mandel::Tracer> tracer;
+    if (!args.trace_path.empty())
+      tracer.emplace();
+    Runner runner(stats ? &*stats : nullptr, tracer ? &*tracer : nullptr);
+    auto write_reports = [&] {
+      if (stats)
+        write_stats(args.stats_path, *stats, process.elapsed());
+      runner.stop();
+      if (tracer)
+        tracer->write(args.trace_path);
+    };
+    if (args.batch_path) {
+      if (!args.series_report.empty())
+        throw std::runtime_error("--series-report cannot be used with --batch");
+      if (stats)
+        stats->config = process.elapsed();
+      const int failed = run_batch(args, runner);
+      write_reports();
+      if (failed != 0) {
+        std::cerr << "Error: " << failed << " batch variant(s) failed\n";
+        return 1;
+      }
+      return 0;
+    }
+    finalize(args);
+    if (stats)
+      stats->config = process.elapsed();
+    runner.run(args);
+    write_reports();
     return 0;
   } catch (const std::exception &e) {
     std::cerr << "Error: " << e.what() << "\nUse --help for usage.\n";
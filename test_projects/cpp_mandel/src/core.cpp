@@ -1,47 +1,1326 @@
 #include "mandel/core.hpp"
-#include <fstream>
+#include "mandel/aligned.hpp"
+#include "mandel/kernels.hpp"
+#include "mandel/parallel.hpp"
+#include "mandel/perturbation.hpp"
+#include "mandel/precision.hpp"
+#include "mandel/trace.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 
 namespace mandel {
 
 std::pair<double, double> mandelbrot_last_state(double cx, double cy,
                                                 int max_iters) {
+  return last_state<double>(cx, cy, max_iters);
+}
+
+Precision resolve_precision(const Params &p) {
+  if (p.engine != Engine::grid) {
+    if (p.precision == Precision::automatic || p.precision == Precision::f64)
+      return Precision::f64;
+    throw std::runtime_error(std::string("Precision ") +
+                             precision_name(p.precision) +
+                             " is only supported by the grid engine");
+  }
+  if (p.precision != Precision::automatic)
+    return p.precision;
+  // Rounding c to a precision with unit roundoff eps moves it by up to
+  // |c| * eps; keep that well below the spacing of adjacent pixels.
+  constexpr double kMargin = 1024.0;
+  const double extent =
+      0.5 * static_cast<double>(std::max(p.width, p.height)) * p.scale;
+  const double c_max =
+      std::max(std::fabs(p.center_x), std::fabs(p.center_y)) + extent;
+  auto resolves = [&](double eps) { return c_max * eps * kMargin <= p.scale; };
+  if (resolves(ScalarPolicy<float>::epsilon))
+    return Precision::f32;
+  if (resolves(ScalarPolicy<double>::epsilon))
+    return Precision::f64;
+  if (resolves(ScalarPolicy<DoubleDouble>::epsilon))
+    return Precision::dd;
+  if (resolves(ScalarPolicy<QuadDouble>::epsilon))
+    return Precision::qd;
+  throw std::runtime_error("scale is too small to resolve even in "
+                           "quad-double precision");
+}
+
+namespace {
+
+// Brent cycle detection. Exact mode compares bit patterns, since +0 == -0
+// would not be a true repeat of the state. steps, when given, receives the
+// iterations run before the cycle was found (*iters is then max_iters).
+template <bool Exact>
+std::pair<double, double> last_state_brent(double cx, double cy, int max_iters,
+                                           double tol, int *iters,
+                                           int *steps = nullptr) {
+  auto same = [tol](double a, double b) {
+    if constexpr (Exact)
+      return std::bit_cast<std::uint64_t>(a) == std::bit_cast<std::uint64_t>(b);
+    else
+      return (a > b ? a - b : b - a) <= tol;
+  };
   double zr = 0.0, zi = 0.0;
+  double sr = 0.0, si = 0.0; // z saved at the last power of two
+  std::int64_t lam = 0, power = 1;
   int it = 0;
+  if (steps)
+    *steps = max_iters;
   while (it < max_iters && (zr * zr + zi * zi) <= 4.0) {
     const double zr2 = zr * zr - zi * zi + cx;
     const double zi2 = 2.0 * zr * zi + cy;
     zr = zr2;
     zi = zi2;
     ++it;
+    if (same(zr, sr) && same(zi, si)) {
+      if (steps)
+        *steps = it;
+      // Period lam + 1: jump to the same phase of the cycle at max_iters.
+      for (std::int64_t r = (max_iters - it) % (lam + 1); r > 0; --r) {
+        const double zr3 = zr * zr - zi * zi + cx;
+        const double zi3 = 2.0 * zr * zi + cy;
+        zr = zr3;
+        zi = zi3;
+      }
+      it = max_iters;
+      break;
+    }
+    if (++lam == power) {
+      sr = zr;
+      si = zi;
+      power *= 2;
+      lam = 0;
+    }
   }
+  if (steps && it < max_iters)
+    *steps = it;
+  if (iters)
+    *iters = it;
   return {zr, zi};
 }
 
+} // namespace
+
+std::pair<double, double> mandelbrot_last_state_periodic(double cx, double cy,
+                                                         int max_iters,
+                                                         double tol,
+                                                         int *iters) {
+  if (tol < 0.0)
+    return last_state<double>(cx, cy, max_iters, iters);
+  if (tol == 0.0)
+    return last_state_brent<true>(cx, cy, max_iters, tol, iters);
+  return last_state_brent<false>(cx, cy, max_iters, tol, iters);
+}
+
+namespace {
+
+// Small tiles keep the work-stealing queues busy: per-pixel cost differs by
+// orders of magnitude between exterior and interior points.
+constexpr int kTileWidth = 64;
+constexpr int kTileHeight = 8;
+
+constexpr std::size_t kTilePixels =
+    static_cast<std::size_t>(kTileWidth) * kTileHeight;
+
+// Engine::perturbation and the software precisions work on offsets from
+// the exact center (pixel_offset) rather than on c itself.
+bool uses_offsets(const Params &p) {
+  const Precision precision = resolve_precision(p);
+  return p.engine == Engine::perturbation || precision == Precision::dd ||
+         precision == Precision::qd;
+}
+
+// Per-column and per-row coordinates, built once per grid: x[px] and y[py]
+// are bit for bit the map_pixel_to_plane() (or pixel_offset()) values of
+// pixel (px, py), since each depends only on its own index. Aligned, so the
+// tile loops read them with plain vector loads instead of recomputing both
+// coordinates for every pixel.
+struct PlaneAxes {
+  AlignedVector<double> x;
+  AlignedVector<double> y;
+};
+
+PlaneAxes plane_axes(const Params &p, bool offsets) {
+  auto at = [&](int px, int py) {
+    return offsets ? pixel_offset(p, px, py) : map_pixel_to_plane(p, px, py);
+  };
+  PlaneAxes a{AlignedVector<double>(static_cast<std::size_t>(p.width)),
+              AlignedVector<double>(static_cast<std::size_t>(p.height))};
+  for (int px = 0; px < p.width; ++px)
+    a.x[static_cast<std::size_t>(px)] = at(px, 0).first;
+  for (int py = 0; py < p.height; ++py)
+    a.y[static_cast<std::size_t>(py)] = at(0, py).second;
+  return a;
+}
+
+// Row-major destination of the tile routines, whose first row is image row
+// row0: pixel (px, py) goes to x[i], y[i] with i = (py - row0) * width + px.
+// The extra channels are null unless requested; `it` is also set for
+// Channel::smooth.
+struct TileOut {
+  double *x;
+  double *y;
+  int width;
+  int row0;
+  std::uint32_t *it = nullptr;
+  std::uint8_t *escaped = nullptr;
+  double *smooth = nullptr;
+  // Pixels already filled in (compute_grid_incremental), skipped by the
+  // Engine::grid tile routines; null: none.
+  const std::uint8_t *done = nullptr;
+
+  std::size_t row(int py) const {
+    return static_cast<std::size_t>(py - row0) *
+           static_cast<std::size_t>(width);
+  }
+};
+
+// All rows of g, the first being image row row0.
+TileOut tile_out(GridResult &g, int row0) {
+  return {g.x(),          g.y(),       g.width(), row0,
+          g.iterations(), g.escaped(), g.smooth()};
+}
+
+// Iterations of pixels that skip the escape loop (interior points): they
+// never escape, so they count max_iters.
+void fill_max_iters(std::uint32_t *it, std::size_t n, int max_iters) {
+  if (it)
+    std::fill_n(it, n, static_cast<std::uint32_t>(max_iters));
+}
+
+// Gather the tile's plane coordinates into a pixel queue, run the batch
+// kernel over it, then scatter the results into the output.
+// Points that the cardioid/bulb test proves interior are queued from the
+// back of the same arrays and handed to the interior kernel instead.
+// Cardioid/bulb orbits take a few hundred to a few thousand steps to repeat
+// bit for bit. Below this budget the branch-free interior kernel beats the
+// escape kernel's cycle detection (crossover measured near 2000 on AVX-512).
+constexpr int kInteriorCycleMinIters = 2048;
+
+BatchKernelFn interior_kernel(const Params &p, Kernel kernel) {
+  if (p.interior == Interior::attractor)
+    return &interior_attractor_kernel;
+  if (p.cycle_tol >= 0.0 && p.max_iters >= kInteriorCycleMinIters)
+    return kernel_fn(kernel);
+  return interior_exact_fn(kernel);
+}
+
+struct TileKernels {
+  BatchKernelFn escape;
+  BatchKernelFn interior;
+  // Fill::exact of Engine::subdivide: no bailout checks, unless Engine::grid
+  // would run the same pixels through Brent cycle detection.
+  BatchKernelFn fill;
+};
+
+TileKernels tile_kernels(const Params &p) {
+  const Kernel kernel = resolve_kernel(p.kernel);
+  const BatchKernelFn escape = kernel == Kernel::scalar
+                                   ? unrolled_kernel_fn(p.unroll)
+                                   : kernel_fn(kernel);
+  return {escape, interior_kernel(p, kernel),
+          p.cycle_tol < 0.0 ? interior_exact_fn(kernel) : kernel_fn(kernel)};
+}
+
+// Marks a tile pixel that was not queued (see TileOut::done).
+constexpr std::size_t kNoSlot = ~std::size_t{0};
+
+// Scatter a tile's queued results (slot[n] holds pixel n of the tile, in row
+// order) into the output.
+template <class T>
+void scatter_tile(const Tile &t, const TileOut &out, const std::size_t *slot,
+                  const T *zx, const T *zy, const std::uint32_t *it) {
+  std::size_t n = 0;
+  for (int py = t.y0; py < t.y1; ++py) {
+    const std::size_t row = out.row(py);
+    double *ox = out.x + row, *oy = out.y + row;
+    std::uint32_t *oit = it ? out.it + row : nullptr;
+    for (int px = t.x0; px < t.x1; ++px, ++n) {
+      if (slot[n] == kNoSlot)
+        continue;
+      ox[px] = zx[slot[n]];
+      oy[px] = zy[slot[n]];
+      if (oit)
+        oit[px] = it[slot[n]];
+    }
+  }
+}
+
+void compute_tile(const Params &p, const TileKernels &k, const PlaneAxes &a,
+                  const Tile &t, const TileOut &out) {
+  alignas(kCacheLine) std::array<double, kTilePixels> cx, cy, zx, zy;
+  alignas(kCacheLine) std::array<std::uint32_t, kTilePixels> its;
+  std::uint32_t *const it = out.it ? its.data() : nullptr;
+  std::array<std::size_t, kTilePixels> slot;
+  const bool test_interior = p.interior != Interior::iterate;
+  std::size_t front = 0, back = kTilePixels, n = 0;
+  for (int py = t.y0; py < t.y1; ++py) {
+    const double y = a.y[static_cast<std::size_t>(py)];
+    const std::uint8_t *done = out.done ? out.done + out.row(py) : nullptr;
+    for (int px = t.x0; px < t.x1; ++px, ++n) {
+      if (done && done[px]) {
+        slot[n] = kNoSlot;
+        continue;
+      }
+      const double x = a.x[static_cast<std::size_t>(px)];
+      const std::size_t s =
+          test_interior && in_cardioid_or_bulb(x, y) ? --back : front++;
+      cx[s] = x;
+      cy[s] = y;
+      slot[n] = s;
+    }
+  }
+  k.escape(PixelBatch{cx.data(), cy.data(), front, p.max_iters, zx.data(),
+                      zy.data(), p.cycle_tol, it});
+  if (back < kTilePixels) {
+    fill_max_iters(it ? it + back : it, kTilePixels - back, p.max_iters);
+    const PixelBatch interior{cx.data() + back, cy.data() + back,
+                              kTilePixels - back, p.max_iters,
+                              zx.data() + back, zy.data() + back,
+                              p.cycle_tol, it ? it + back : it};
+    k.interior(interior);
+  }
+  scatter_tile(t, out, slot.data(), zx.data(), zy.data(), it);
+}
+
+// compute_tile() for Precision::f32: c is mapped in double, then rounded to
+// float. Interior points always take the no-bailout path (attractor mode
+// included).
+void compute_tile_f32(const Params &p, BatchKernelF32Fn kernel,
+                      const PlaneAxes &a, const Tile &t, const TileOut &out) {
+  alignas(kCacheLine) std::array<float, kTilePixels> cx, cy, zx, zy;
+  alignas(kCacheLine) std::array<std::uint32_t, kTilePixels> its;
+  std::uint32_t *const it = out.it ? its.data() : nullptr;
+  std::array<std::size_t, kTilePixels> slot;
+  const bool test_interior = p.interior != Interior::iterate;
+  std::size_t front = 0, back = kTilePixels, n = 0;
+  for (int py = t.y0; py < t.y1; ++py) {
+    const double y = a.y[static_cast<std::size_t>(py)];
+    const std::uint8_t *done = out.done ? out.done + out.row(py) : nullptr;
+    for (int px = t.x0; px < t.x1; ++px, ++n) {
+      if (done && done[px]) {
+        slot[n] = kNoSlot;
+        continue;
+      }
+      const double x = a.x[static_cast<std::size_t>(px)];
+      const std::size_t s =
+          test_interior && in_cardioid_or_bulb(x, y) ? --back : front++;
+      cx[s] = static_cast<float>(x);
+      cy[s] = static_cast<float>(y);
+      slot[n] = s;
+    }
+  }
+  kernel(PixelBatchF32{cx.data(), cy.data(), front, p.max_iters, zx.data(),
+                       zy.data(), -1.0, it});
+  if (back < kTilePixels) {
+    fill_max_iters(it ? it + back : it, kTilePixels - back, p.max_iters);
+    interior_exact_kernel_f32(PixelBatchF32{
+        cx.data() + back, cy.data() + back, kTilePixels - back, p.max_iters,
+        zx.data() + back, zy.data() + back});
+  }
+  scatter_tile(t, out, slot.data(), zx.data(), zy.data(), it);
+}
+
+// The view center in precision T, from the center text when given.
+template <class T> std::pair<T, T> center_as(const Params &p) {
+  if constexpr (std::is_same_v<T, DoubleDouble>) {
+    return view_center(p);
+  } else {
+    auto parse = [](const std::string &text, double value) {
+      return text.empty() ? ScalarPolicy<T>::from_double(value)
+                          : parse_quad_double(text);
+    };
+    return {parse(p.center_x_text, p.center_x),
+            parse(p.center_y_text, p.center_y)};
+  }
+}
+
+// Precision::dd / qd: c = center + offset in T, one pixel at a time (the
+// software types gain nothing from the batch kernels' lanes).
+template <class T>
+void compute_tile_soft(const Params &p, const std::pair<T, T> &center,
+                       const PlaneAxes &offsets, const Tile &t,
+                       const TileOut &out) {
+  using S = ScalarPolicy<T>;
+  for (int py = t.y0; py < t.y1; ++py) {
+    double *ox = out.x + out.row(py), *oy = out.y + out.row(py);
+    std::uint32_t *oit = out.it ? out.it + out.row(py) : nullptr;
+    const T cy =
+        center.second + S::from_double(offsets.y[static_cast<std::size_t>(py)]);
+    for (int px = t.x0; px < t.x1; ++px) {
+      const double dx = offsets.x[static_cast<std::size_t>(px)];
+      int it = 0;
+      const auto [zr, zi] =
+          last_state<T>(center.first + S::from_double(dx), cy, p.max_iters,
+                        oit ? &it : nullptr);
+      ox[px] = zr;
+      oy[px] = zi;
+      if (oit)
+        oit[px] = static_cast<std::uint32_t>(it);
+    }
+  }
+}
+
+// ---------- Mariani-Silver subdivision ----------
+
+// Top-level rectangle of Engine::subdivide, and the side length below which
+// a rectangle is computed pixel by pixel.
+constexpr int kBlockSize = 64;
+constexpr int kMinRect = 6;
+
+bool escaped(double x, double y) { return !(x * x + y * y <= 4.0); }
+
+// One Engine::subdivide block. Pixels are evaluated in batches: each
+// rectangle queues its not yet known border pixels and runs them through
+// the same cardioid/bulb split as compute_tile. If no border pixel escaped,
+// the rectangle's inside is filled according to p.fill; otherwise it is
+// split into four quadrants that share their middle row and column.
+class Subdivision {
+public:
+  Subdivision(const Params &p, const TileKernels &k, const PlaneAxes &a,
+              const Tile &t)
+      : p_(p), k_(k), a_(a), t_(t), w_(t.x1 - t.x0),
+        n_(static_cast<std::size_t>(w_) *
+           static_cast<std::size_t>(t.y1 - t.y0)),
+        zx_(n_), zy_(n_), known_(n_, 0) {}
+
+  void run(const TileOut &out) {
+    if (out.it)
+      it_.resize(n_);
+    rect(t_.x0, t_.y0, t_.x1, t_.y1);
+    for (int py = t_.y0; py < t_.y1; ++py) {
+      double *ox = out.x + out.row(py), *oy = out.y + out.row(py);
+      for (int px = t_.x0; px < t_.x1; ++px) {
+        const std::size_t i = at(px, py);
+        ox[px] = zx_[i];
+        oy[px] = zy_[i];
+      }
+      if (out.it)
+        std::copy_n(it_.data() + at(t_.x0, py), w_,
+                    out.it + out.row(py) + t_.x0);
+    }
+  }
+
+private:
+  std::size_t at(int x, int y) const {
+    return static_cast<std::size_t>(y - t_.y0) * static_cast<std::size_t>(w_) +
+           static_cast<std::size_t>(x - t_.x0);
+  }
+
+  void want(int x, int y) {
+    const std::size_t i = at(x, y);
+    if (!known_[i]) {
+      known_[i] = 1;
+      pending_.push_back(i);
+    }
+  }
+
+  // Evaluate the pending pixels: cardioid/bulb points with k_.interior, the
+  // rest with `rest`.
+  void eval(BatchKernelFn rest) {
+    const std::size_t n = pending_.size();
+    if (n == 0)
+      return;
+    cx_.resize(n);
+    cy_.resize(n);
+    ox_.resize(n);
+    oy_.resize(n);
+    slot_.resize(n);
+    // Only the escape kernels count iterations; the rest never escape.
+    std::uint32_t *oit = nullptr;
+    if (!it_.empty()) {
+      oit_.assign(n, static_cast<std::uint32_t>(p_.max_iters));
+      oit = oit_.data();
+    }
+    const bool test_interior = p_.interior != Interior::iterate;
+    std::size_t front = 0, back = n;
+    for (std::size_t j = 0; j < n; ++j) {
+      const std::size_t i = pending_[j];
+      const int px = t_.x0 + static_cast<int>(i % static_cast<std::size_t>(w_));
+      const int py = t_.y0 + static_cast<int>(i / static_cast<std::size_t>(w_));
+      const double x = a_.x[static_cast<std::size_t>(px)];
+      const double y = a_.y[static_cast<std::size_t>(py)];
+      const std::size_t s =
+          test_interior && in_cardioid_or_bulb(x, y) ? --back : front++;
+      cx_[s] = x;
+      cy_[s] = y;
+      slot_[j] = s;
+    }
+    rest(PixelBatch{cx_.data(), cy_.data(), front, p_.max_iters, ox_.data(),
+                    oy_.data(), p_.cycle_tol, oit});
+    if (back < n)
+      k_.interior(PixelBatch{cx_.data() + back, cy_.data() + back, n - back,
+                             p_.max_iters, ox_.data() + back,
+                             oy_.data() + back, p_.cycle_tol,
+                             oit ? oit + back : oit});
+    for (std::size_t j = 0; j < n; ++j) {
+      zx_[pending_[j]] = ox_[slot_[j]];
+      zy_[pending_[j]] = oy_[slot_[j]];
+      if (oit)
+        it_[pending_[j]] = oit[slot_[j]];
+    }
+    pending_.clear();
+  }
+
+  // Half-open rectangle [x0, x1) x [y0, y1).
+  void rect(int x0, int y0, int x1, int y1) {
+    if (x1 - x0 <= kMinRect || y1 - y0 <= kMinRect) {
+      for (int y = y0; y < y1; ++y)
+        for (int x = x0; x < x1; ++x)
+          want(x, y);
+      eval(k_.escape);
+      return;
+    }
+    for (int x = x0; x < x1; ++x) {
+      want(x, y0);
+      want(x, y1 - 1);
+    }
+    for (int y = y0 + 1; y < y1 - 1; ++y) {
+      want(x0, y);
+      want(x1 - 1, y);
+    }
+    eval(k_.escape);
+    bool inside = true;
+    for (int x = x0; x < x1 && inside; ++x)
+      inside = !border_escaped(x, y0) && !border_escaped(x, y1 - 1);
+    for (int y = y0 + 1; y < y1 - 1 && inside; ++y)
+      inside = !border_escaped(x0, y) && !border_escaped(x1 - 1, y);
+    if (inside) {
+      fill(x0, y0, x1, y1);
+      return;
+    }
+    const int xm = (x0 + x1) / 2, ym = (y0 + y1) / 2;
+    rect(x0, y0, xm + 1, ym + 1);
+    rect(xm, y0, x1, ym + 1);
+    rect(x0, ym, xm + 1, y1);
+    rect(xm, ym, x1, y1);
+  }
+
+  bool border_escaped(int x, int y) const {
+    const std::size_t i = at(x, y);
+    return escaped(zx_[i], zy_[i]);
+  }
+
+  void fill(int x0, int y0, int x1, int y1) {
+    if (p_.fill == Fill::approximate) {
+      for (int y = y0 + 1; y < y1 - 1; ++y) {
+        for (int x = x0 + 1; x < x1 - 1; ++x) {
+          const int dl = x - x0, dr = x1 - 1 - x, dt = y - y0, db = y1 - 1 - y;
+          const int d = std::min({dl, dr, dt, db});
+          const std::size_t src = d == dl   ? at(x0, y)
+                                  : d == dr ? at(x1 - 1, y)
+                                  : d == dt ? at(x, y0)
+                                            : at(x, y1 - 1);
+          const std::size_t i = at(x, y);
+          zx_[i] = zx_[src];
+          zy_[i] = zy_[src];
+          if (!it_.empty())
+            it_[i] = it_[src];
+          known_[i] = 1;
+        }
+      }
+      return;
+    }
+    for (int y = y0 + 1; y < y1 - 1; ++y)
+      for (int x = x0 + 1; x < x1 - 1; ++x)
+        want(x, y);
+    if (k_.fill == k_.escape) {
+      eval(k_.escape);
+      return;
+    }
+    filled_ = pending_;
+    eval(k_.fill);
+    // Exterior filaments can pass between border pixels. Their orbits grow
+    // past |z| = 2 (or overflow to NaN) under the no-bailout loop, so they
+    // are easy to spot and redo with the escape kernel.
+    for (std::size_t i : filled_) {
+      if (escaped(zx_[i], zy_[i]))
+        pending_.push_back(i);
+    }
+    eval(k_.escape);
+  }
+
+  const Params &p_;
+  const TileKernels &k_;
+  const PlaneAxes &a_;
+  Tile t_;
+  int w_;
+  std::size_t n_;
+  std::vector<double> zx_, zy_;
+  std::vector<unsigned char> known_;
+  std::vector<std::size_t> pending_, filled_, slot_;
+  std::vector<double> cx_, cy_, ox_, oy_;
+  // Iteration counts, only when the output has them.
+  std::vector<std::uint32_t> it_, oit_;
+};
+
+// Largest |dc| over the pixels of t.
+double tile_radius(const Params &p, const Tile &t) {
+  double r = 0.0;
+  for (int py : {t.y0, t.y1 - 1}) {
+    for (int px : {t.x0, t.x1 - 1}) {
+      const auto [dx, dy] = pixel_offset(p, px, py);
+      r = std::max(r, std::hypot(dx, dy));
+    }
+  }
+  return r;
+}
+
+// Returns the iterations skipped per pixel (0 without a series).
+int perturbation_tile(const Params &p, const ReferenceOrbit &ref,
+                      const SeriesApproximation *series,
+                      const PlaneAxes &offsets, const Tile &t,
+                      const TileOut &out) {
+  const int skip = series ? series->skip(tile_radius(p, t)) : 0;
+  for (int py = t.y0; py < t.y1; ++py) {
+    double *ox = out.x + out.row(py), *oy = out.y + out.row(py);
+    std::uint32_t *oit = out.it ? out.it + out.row(py) : nullptr;
+    const double dy = offsets.y[static_cast<std::size_t>(py)];
+    for (int px = t.x0; px < t.x1; ++px) {
+      const double dx = offsets.x[static_cast<std::size_t>(px)];
+      double dzr = 0.0, dzi = 0.0;
+      if (skip > 0)
+        std::tie(dzr, dzi) = series->delta(skip, dx, dy);
+      int it = 0;
+      const auto [zr, zi] = perturbed_last_state(
+          ref, dx, dy, p.max_iters, skip, dzr, dzi, oit ? &it : nullptr);
+      ox[px] = zr;
+      oy[px] = zi;
+      if (oit)
+        oit[px] = static_cast<std::uint32_t>(it);
+    }
+  }
+  return skip;
+}
+
+// Tile shape and per-tile routine of p.engine, bound to its kernels (and
+// for Engine::perturbation, the shared reference orbit and series). The
+// routine returns TileReport::series_skipped.
+struct TileEngine {
+  int tile_w;
+  int tile_h;
+  std::function<int(const Tile &, const TileOut &)> compute;
+};
+
+// Channel::escaped and Channel::smooth of a computed tile, from its final z
+// and iteration counts.
+void derive_channels(const Params &p, const Tile &t, const TileOut &out) {
+  for (int py = t.y0; py < t.y1; ++py) {
+    const std::size_t row = out.row(py);
+    const double *x = out.x + row, *y = out.y + row;
+    for (int px = t.x0; px < t.x1; ++px) {
+      const double m = x[px] * x[px] + y[px] * y[px];
+      const bool esc = !(m <= 4.0);
+      if (out.escaped)
+        out.escaped[row + static_cast<std::size_t>(px)] = esc ? 1 : 0;
+      if (out.smooth) {
+        const std::size_t i = row + static_cast<std::size_t>(px);
+        out.smooth[i] = esc ? out.it[i] + 1.0 - std::log2(0.5 * std::log(m))
+                            : static_cast<double>(p.max_iters);
+      }
+    }
+  }
+}
+
+// Compute one tile and report it to p.on_tile.
+void run_tile(const Params &p, const TileEngine &e, const Tile &t,
+              const TileOut &out) {
+  const int skipped = e.compute(t, out);
+  if (out.escaped || out.smooth)
+    derive_channels(p, t, out);
+  if (p.on_tile)
+    p.on_tile(TileReport{t.x0, t.y0, t.x1, t.y1, skipped});
+}
+
+// run_tile() on pool participant `worker`, recorded when the pool traces.
+void run_tile(const Params &p, const TileEngine &e, const Tile &t,
+              const TileOut &out, const ThreadPool &pool, int worker) {
+  Tracer *trace = pool.tracer();
+  if (!trace) {
+    run_tile(p, e, t, out);
+    return;
+  }
+  const std::uint64_t t0 = trace->now();
+  run_tile(p, e, t, out);
+  trace->record(worker, TraceKind::tile, t0, trace->now(),
+                {t.x0, t.y0, t.x1, t.y1});
+}
+
+template <class T>
+TileEngine soft_tile_engine(const Params &p,
+                            std::shared_ptr<const PlaneAxes> axes) {
+  return {kTileWidth, kTileHeight,
+          [&p, center = center_as<T>(p), axes](const Tile &t,
+                                               const TileOut &out) {
+            compute_tile_soft<T>(p, center, *axes, t, out);
+            return 0;
+          }};
+}
+
+TileEngine tile_engine(const Params &p, const TileKernels &k) {
+  const Precision precision = resolve_precision(p);
+  auto axes =
+      std::make_shared<const PlaneAxes>(plane_axes(p, uses_offsets(p)));
+  switch (p.engine) {
+  case Engine::subdivide:
+    return {kBlockSize, kBlockSize,
+            [&p, &k, axes](const Tile &t, const TileOut &out) {
+              Subdivision(p, k, *axes, t).run(out);
+              return 0;
+            }};
+  case Engine::perturbation: {
+    const auto [cx, cy] = view_center(p);
+    auto ref = std::make_shared<const ReferenceOrbit>(
+        reference_orbit(cx, cy, p.max_iters));
+    std::shared_ptr<const SeriesApproximation> series;
+    if (p.series_order > 0) {
+      // Radius of the whole view; no tile is narrower than a pixel.
+      const double radius =
+          std::hypot(static_cast<double>(p.width), p.height) * 0.5 * p.scale;
+      series = std::make_shared<const SeriesApproximation>(
+          *ref, p.series_order, p.series_tol, radius, p.scale);
+    }
+    return {kTileWidth, kTileHeight,
+            [&p, ref, series, axes](const Tile &t, const TileOut &out) {
+              return perturbation_tile(p, *ref, series.get(), *axes, t, out);
+            }};
+  }
+  case Engine::grid:
+    break;
+  }
+  switch (precision) {
+  case Precision::f32:
+    return {kTileWidth, kTileHeight,
+            [&p, f = kernel_f32_fn(p.kernel), axes](const Tile &t,
+                                                    const TileOut &out) {
+              compute_tile_f32(p, f, *axes, t, out);
+              return 0;
+            }};
+  case Precision::dd:
+    return soft_tile_engine<DoubleDouble>(p, axes);
+  case Precision::qd:
+    return soft_tile_engine<QuadDouble>(p, axes);
+  default:
+    break;
+  }
+  return {kTileWidth, kTileHeight,
+          [&p, &k, axes](const Tile &t, const TileOut &out) {
+            compute_tile(p, k, *axes, t, out);
+            return 0;
+          }};
+}
+
+// Row mirroring. Conjugate c gives the conjugate orbit bit for bit: every
+// step only squares zi or multiplies it by a sign-symmetric product, and
+// round-to-nearest is symmetric about zero. The one asymmetry is an exact
+// cancellation, which yields +0 for both signs, hence mirror_y().
+struct MirrorPlan {
+  // Earlier, computed row whose cy is exactly -cy of this row, or -1 if the
+  // row is computed. cx depends only on px, so such rows are conjugates.
+  std::vector<int> source;
+  // Number of later rows mirrored from this row.
+  std::vector<int> uses;
+};
+
+MirrorPlan plan_mirror(const Params &p) {
+  MirrorPlan m{std::vector<int>(static_cast<std::size_t>(p.height), -1),
+               std::vector<int>(static_cast<std::size_t>(p.height), 0)};
+  if (!p.symmetry)
+    return m;
+  // With offsets, the exact center must lie on the real axis itself.
+  const bool offsets = uses_offsets(p);
+  if (offsets && view_center(p).second.hi != 0.0)
+    return m;
+  std::unordered_map<std::uint64_t, int> computed; // cy bits -> row
+  for (int py = 0; py < p.height; ++py) {
+    const double cy = offsets ? pixel_offset(p, 0, py).second
+                              : map_pixel_to_plane(p, 0, py).second;
+    if (cy != 0.0) {
+      auto it = computed.find(std::bit_cast<std::uint64_t>(-cy));
+      if (it != computed.end()) {
+        m.source[static_cast<std::size_t>(py)] = it->second;
+        ++m.uses[static_cast<std::size_t>(it->second)];
+        continue;
+      }
+    }
+    computed.emplace(std::bit_cast<std::uint64_t>(cy), py);
+  }
+  return m;
+}
+
+double mirror_y(double y) { return y == 0.0 ? y : -y; }
+
+// Row py of dst becomes a copy of the first row of src, every channel of
+// dst included; with `conjugate`, y is mirrored.
+void copy_row(const GridView &src, const TileOut &dst, int py,
+              bool conjugate) {
+  const std::size_t row = dst.row(py);
+  const std::size_t w = static_cast<std::size_t>(src.width);
+  std::copy_n(src.x, w, dst.x + row);
+  if (conjugate) {
+    for (std::size_t i = 0; i < w; ++i)
+      dst.y[row + i] = mirror_y(src.y[i]);
+  } else {
+    std::copy_n(src.y, w, dst.y + row);
+  }
+  if (dst.it)
+    std::copy_n(src.iterations, w, dst.it + row);
+  if (dst.escaped)
+    std::copy_n(src.escaped, w, dst.escaped + row);
+  if (dst.smooth)
+    std::copy_n(src.smooth, w, dst.smooth + row);
+}
+
+// Tiles covering the rows of [y0, y1) that are computed, not mirrored.
+std::vector<Tile> plan_tiles(const Params &p, const TileEngine &e,
+                             const MirrorPlan &m, int y0, int y1) {
+  std::vector<Tile> tiles;
+  for (int a = y0; a < y1;) {
+    if (m.source[static_cast<std::size_t>(a)] >= 0) {
+      ++a;
+      continue;
+    }
+    int b = a + 1;
+    while (b < y1 && m.source[static_cast<std::size_t>(b)] < 0)
+      ++b;
+    for (Tile t : make_tiles(p.width, b - a, e.tile_w, e.tile_h)) {
+      t.y0 += a;
+      t.y1 += a;
+      tiles.push_back(t);
+    }
+    a = b;
+  }
+  return tiles;
+}
+
+// ---------- Scheduling ----------
+
+// Schedule::cost pre-pass: one sample per kCostStride x kCostStride pixels.
+constexpr int kCostStride = 4;
+// Schedule::cost splits tiles estimated above 1 / (kCostShares * threads)
+// of the total.
+constexpr int kCostShares = 8;
+
+// Loop iterations compute_tile() spends on a point c that never escaped.
+// Its iteration count (max_iters) overstates them: the attractor settles
+// cardioid/bulb points without iterating, and cycle detection stops at
+// the first repeat of the orbit.
+std::uint64_t interior_cost(const Params &p, double cx, double cy) {
+  const bool interior =
+      p.interior != Interior::iterate && in_cardioid_or_bulb(cx, cy);
+  if (interior && p.interior == Interior::attractor)
+    return 1;
+  if (p.cycle_tol < 0.0 || (interior && p.max_iters < kInteriorCycleMinIters))
+    return static_cast<std::uint64_t>(p.max_iters);
+  int steps = 0;
+  if (p.cycle_tol == 0.0)
+    last_state_brent<true>(cx, cy, p.max_iters, 0.0, nullptr, &steps);
+  else
+    last_state_brent<false>(cx, cy, p.max_iters, p.cycle_tol, nullptr,
+                            &steps);
+  return static_cast<std::uint64_t>(steps);
+}
+
+// Estimated iterations over pixel rectangles of a view, from the iteration
+// counts of the same view at 1/kCostStride of the resolution per axis, kept
+// as a summed-area table. Under the f64 grid kernels, which alone honor
+// Params::interior and Params::cycle_tol, samples that never escaped are
+// charged by interior_cost() instead.
+class CostMap {
+public:
+  CostMap(const Params &p, ThreadPool &pool) {
+    Params coarse = p;
+    coarse.width = (p.width + kCostStride - 1) / kCostStride;
+    coarse.height = (p.height + kCostStride - 1) / kCostStride;
+    coarse.scale = p.scale * kCostStride;
+    coarse.schedule = Schedule::steal;
+    coarse.on_tile = nullptr;
+    coarse.channels = {Channel::x, Channel::y, Channel::iterations};
+    GridResult g;
+    compute_grid(coarse, g, pool);
+    w_ = coarse.width;
+    h_ = coarse.height;
+    const bool recount = p.engine != Engine::perturbation &&
+                         resolve_precision(p) == Precision::f64;
+    const PlaneAxes a = recount ? plane_axes(coarse, false) : PlaneAxes{};
+    // interior_cost() runs a scalar loop, so it is taken once per 2 x 2
+    // samples, at the top-left one; kUnset marks blocks not yet taken.
+    constexpr std::uint64_t kUnset = ~std::uint64_t{0};
+    std::vector<std::uint64_t> block(static_cast<std::size_t>(w_ + 1) / 2);
+    sum_.assign(static_cast<std::size_t>(w_ + 1) * (h_ + 1), 0);
+    for (int y = 0; y < h_; ++y) {
+      if (y % 2 == 0)
+        std::fill(block.begin(), block.end(), kUnset);
+      std::uint64_t row = 0;
+      for (int x = 0; x < w_; ++x) {
+        std::uint64_t it = g.iterations()[static_cast<std::size_t>(y) * w_ + x];
+        if (recount && it == static_cast<std::uint64_t>(p.max_iters)) {
+          std::uint64_t &b = block[static_cast<std::size_t>(x / 2)];
+          if (b == kUnset)
+            b = interior_cost(p, a.x[static_cast<std::size_t>(x & ~1)],
+                              a.y[static_cast<std::size_t>(y & ~1)]);
+          it = b;
+        }
+        // Plus one for the work per pixel outside the escape loop.
+        row += it + 1u;
+        at(x + 1, y + 1) = at(x + 1, y) + row;
+      }
+    }
+  }
+
+  // Estimated iterations of the pixels of t.
+  double cost(const Tile &t) const {
+    const int x0 = std::min(t.x0 / kCostStride, w_ - 1);
+    const int y0 = std::min(t.y0 / kCostStride, h_ - 1);
+    const int x1 = std::clamp((t.x1 + kCostStride - 1) / kCostStride, x0 + 1,
+                              w_);
+    const int y1 = std::clamp((t.y1 + kCostStride - 1) / kCostStride, y0 + 1,
+                              h_);
+    const std::uint64_t sum =
+        at(x1, y1) - at(x0, y1) - at(x1, y0) + at(x0, y0);
+    const double pixels = static_cast<double>(t.x1 - t.x0) * (t.y1 - t.y0);
+    const double cells = static_cast<double>(x1 - x0) * (y1 - y0);
+    return static_cast<double>(sum) * pixels / cells;
+  }
+
+private:
+  std::uint64_t &at(int x, int y) {
+    return sum_[static_cast<std::size_t>(y) * (w_ + 1) + x];
+  }
+  std::uint64_t at(int x, int y) const {
+    return sum_[static_cast<std::size_t>(y) * (w_ + 1) + x];
+  }
+
+  int w_ = 0;
+  int h_ = 0;
+  std::vector<std::uint64_t> sum_; // (w_ + 1) x (h_ + 1), zero first row
+};
+
+// The tiles of one pass in the order of p.schedule, grouped into pool
+// tasks: task i computes tiles [first[i], first[i + 1]) in turn.
+struct TaskPlan {
+  std::vector<Tile> tiles;
+  std::vector<std::size_t> first;
+  ThreadPool::Deal deal = ThreadPool::Deal::chunks;
+
+  std::size_t tasks() const { return first.size() - 1; }
+};
+
+// tiles in row-major order, as from plan_tiles(); costs is null unless
+// p.schedule is Schedule::cost.
+TaskPlan schedule_tiles(const Params &p, std::vector<Tile> tiles,
+                        const CostMap *costs, int participants) {
+  TaskPlan plan;
+  const std::size_t parts = static_cast<std::size_t>(participants);
+  if (p.schedule == Schedule::rows) {
+    // Equal numbers of tiles, which are whole rows of tiles when the rows
+    // split evenly.
+    plan.first.push_back(0);
+    for (std::size_t r = 1; r <= parts; ++r) {
+      const std::size_t end = tiles.size() * r / parts;
+      if (end > plan.first.back())
+        plan.first.push_back(end);
+    }
+    plan.tiles = std::move(tiles);
+    plan.deal = ThreadPool::Deal::pinned;
+    return plan;
+  }
+  if (p.schedule == Schedule::cost && costs) {
+    struct Costed {
+      Tile t;
+      double cost;
+    };
+    std::vector<Costed> todo;
+    double total = 0.0;
+    for (const Tile &t : tiles) {
+      todo.push_back({t, costs->cost(t)});
+      total += todo.back().cost;
+    }
+    // Grid tiles split into row bands with identical output; other engines
+    // depend on the tile shape (approximate fills, series skips).
+    if (p.engine == Engine::grid) {
+      const double share = total / static_cast<double>(kCostShares * parts);
+      for (std::size_t i = 0; i < todo.size(); ++i) {
+        while (todo[i].cost > share && todo[i].t.y1 - todo[i].t.y0 > 1) {
+          Tile lower = todo[i].t;
+          lower.y0 = (lower.y0 + lower.y1) / 2;
+          todo[i].t.y1 = lower.y0;
+          todo[i].cost = costs->cost(todo[i].t);
+          todo.push_back({lower, costs->cost(lower)});
+        }
+      }
+    }
+    std::stable_sort(
+        todo.begin(), todo.end(),
+        [](const Costed &a, const Costed &b) { return a.cost > b.cost; });
+    tiles.clear();
+    for (const Costed &c : todo)
+      tiles.push_back(c.t);
+    plan.deal = ThreadPool::Deal::interleaved;
+  }
+  plan.first.resize(tiles.size() + 1);
+  for (std::size_t i = 0; i < plan.first.size(); ++i)
+    plan.first[i] = i;
+  plan.tiles = std::move(tiles);
+  return plan;
+}
+
+// Runs the tasks of plan on pool into dst, waiting for all of them.
+void run_plan(const Params &p, const TileEngine &e, const TaskPlan &plan,
+              const TileOut &dst, ThreadPool &pool) {
+  pool.parallel_for(
+      plan.tasks(),
+      [&](std::size_t i, int worker) {
+        for (std::size_t t = plan.first[i]; t < plan.first[i + 1]; ++t)
+          run_tile(p, e, plan.tiles[t], dst, pool, worker);
+      },
+      plan.deal);
+}
+
+// ---------- Incremental recompute ----------
+
+// Whether both views compute each pixel from its c alone and in the same
+// way, so that results can move between the grids by value of c, and prev
+// holds every channel p asks for.
+bool reusable(const Params &prev_params, const GridResult &prev,
+              const Params &p) {
+  auto per_pixel = [](const Params &q) {
+    const Precision precision = resolve_precision(q);
+    return !uses_offsets(q) &&
+           (precision == Precision::f64 || precision == Precision::f32) &&
+           (q.engine == Engine::grid ||
+            (q.engine == Engine::subdivide && q.fill == Fill::exact));
+  };
+  if (prev.width() != prev_params.width ||
+      prev.height() != prev_params.height || !per_pixel(prev_params) ||
+      !per_pixel(p) || p.scale != prev_params.scale ||
+      p.max_iters != prev_params.max_iters ||
+      p.interior != prev_params.interior ||
+      p.cycle_tol != prev_params.cycle_tol ||
+      resolve_precision(p) != resolve_precision(prev_params))
+    return false;
+  for (Channel c : p.channels) {
+    if ((c == Channel::iterations && !prev.iterations()) ||
+        (c == Channel::escaped && !prev.escaped()) ||
+        (c == Channel::smooth && !prev.smooth()))
+      return false;
+  }
+  return true;
+}
+
+// The pixel grids line up when the centers differ by a whole number of
+// pixels, counting the half-pixel shift between odd and even sizes.
+bool aligned(double center_delta, int prev_size, int size, double scale) {
+  const double shift =
+      center_delta / scale + (static_cast<double>(prev_size) - size) / 2.0;
+  return std::fabs(shift - std::round(shift)) <= 1e-6;
+}
+
+// For each coordinate of `to`, the index of the bitwise equal coordinate of
+// `from`, or -1. Both axes increase with the index.
+std::vector<int> match_axis(const AlignedVector<double> &from,
+                            const AlignedVector<double> &to) {
+  std::vector<int> m(to.size(), -1);
+  std::size_t i = 0;
+  for (std::size_t j = 0; j < to.size(); ++j) {
+    while (i < from.size() && from[i] < to[j])
+      ++i;
+    if (i < from.size() && std::bit_cast<std::uint64_t>(from[i]) ==
+                               std::bit_cast<std::uint64_t>(to[j]))
+      m[j] = static_cast<int>(i);
+  }
+  return m;
+}
+
+} // namespace
+
+void compute_grid(const Params &p, GridResult &out) {
+  ThreadPool pool(resolve_threads(p.threads));
+  compute_grid(p, out, pool);
+}
+
+void compute_grid(const Params &p, GridResult &out, ThreadPool &pool) {
+  out.resize(p.width, p.height, p.channels);
+  const TileKernels k = tile_kernels(p);
+  const TileEngine e = tile_engine(p, k);
+  const MirrorPlan m = plan_mirror(p);
+  std::optional<CostMap> costs;
+  if (p.schedule == Schedule::cost)
+    costs.emplace(p, pool);
+  const TaskPlan plan =
+      schedule_tiles(p, plan_tiles(p, e, m, 0, p.height),
+                     costs ? &*costs : nullptr, pool.size());
+  const TileOut dst = tile_out(out, 0);
+  run_plan(p, e, plan, dst, pool);
+  for (int py = 0; py < p.height; ++py) {
+    const int src = m.source[static_cast<std::size_t>(py)];
+    if (src >= 0)
+      copy_row(out.rows(src, 1), dst, py, true);
+  }
+}
+
 void compute_grid(const Params &p, std::vector<PixelResult> &out) {
-  out.clear();
-  out.reserve(static_cast<std::size_t>(p.width) *
-              static_cast<std::size_t>(p.height));
+  ThreadPool pool(resolve_threads(p.threads));
+  compute_grid(p, out, pool);
+}
+
+void compute_grid(const Params &p, std::vector<PixelResult> &out,
+                  ThreadPool &pool) {
+  GridResult g;
+  compute_grid(p, g, pool);
+  out.assign(g.begin(), g.end());
+}
+
+std::size_t compute_grid_incremental(const Params &prev_params,
+                                     const GridResult &prev, const Params &p,
+                                     GridResult &out) {
+  ThreadPool pool(resolve_threads(p.threads));
+  return compute_grid_incremental(prev_params, prev, p, out, pool);
+}
+
+std::size_t compute_grid_incremental(const Params &prev_params,
+                                     const GridResult &prev, const Params &p,
+                                     GridResult &out, ThreadPool &pool) {
+  if (!reusable(prev_params, prev, p) ||
+      !aligned(p.center_x - prev_params.center_x, prev_params.width,
+               p.width, p.scale) ||
+      !aligned(p.center_y - prev_params.center_y, prev_params.height,
+               p.height, p.scale)) {
+    compute_grid(p, out, pool);
+    return 0;
+  }
+  // Whole-pixel offsets still round c differently in some columns and rows;
+  // only bitwise equal coordinates are taken over.
+  const PlaneAxes from = plane_axes(prev_params, false);
+  const PlaneAxes to = plane_axes(p, false);
+  const std::vector<int> mx = match_axis(from.x, to.x);
+  const std::vector<int> my = match_axis(from.y, to.y);
+
+  out.resize(p.width, p.height, p.channels);
+  std::vector<std::uint8_t> done(out.size(), 0);
+  TileOut dst = tile_out(out, 0);
+  const GridView src = prev.view();
+  std::size_t reused = 0;
   for (int py = 0; py < p.height; ++py) {
+    const int sy = my[static_cast<std::size_t>(py)];
+    if (sy < 0)
+      continue;
+    const std::size_t srow = static_cast<std::size_t>(sy) *
+                             static_cast<std::size_t>(src.width);
+    const std::size_t drow = dst.row(py);
     for (int px = 0; px < p.width; ++px) {
-      auto [cx, cy] = map_pixel_to_plane(p, px, py);
-      auto [zr, zi] = mandelbrot_last_state(cx, cy, p.max_iters);
-      out.push_back(PixelResult{px, py, zr, zi});
+      const int sx = mx[static_cast<std::size_t>(px)];
+      if (sx < 0)
+        continue;
+      const std::size_t i = srow + static_cast<std::size_t>(sx);
+      const std::size_t o = drow + static_cast<std::size_t>(px);
+      dst.x[o] = src.x[i];
+      dst.y[o] = src.y[i];
+      if (dst.it)
+        dst.it[o] = src.iterations[i];
+      if (dst.escaped)
+        dst.escaped[o] = src.escaped[i];
+      if (dst.smooth)
+        dst.smooth[o] = src.smooth[i];
+      done[o] = 1;
+      ++reused;
     }
   }
-}
 
-void write_csv(const std::string &path, const std::vector<PixelResult> &data) {
-  std::ofstream ofs(path, std::ios::out | std::ios::trunc);
-  if (!ofs) {
-    throw std::runtime_error("Failed to open CSV for writing: " + path);
+  // The rest through the grid engine's tiles, which skip the copied pixels
+  // (Engine::subdivide with Fill::exact would give the same values).
+  Params grid = p;
+  grid.engine = Engine::grid;
+  const TileKernels k = tile_kernels(grid);
+  const TileEngine e = tile_engine(grid, k);
+  const MirrorPlan m = plan_mirror(grid);
+  std::vector<Tile> tiles = plan_tiles(grid, e, m, 0, p.height);
+  std::erase_if(tiles, [&](const Tile &t) {
+    for (int py = t.y0; py < t.y1; ++py) {
+      const std::uint8_t *row = done.data() + dst.row(py);
+      if (std::find(row + t.x0, row + t.x1, 0) != row + t.x1)
+        return false;
+    }
+    return true;
+  });
+  dst.done = done.data();
+  const TaskPlan plan =
+      schedule_tiles(grid, std::move(tiles), nullptr, pool.size());
+  run_plan(grid, e, plan, dst, pool);
+  for (int py = 0; py < p.height; ++py) {
+    const int from_row = m.source[static_cast<std::size_t>(py)];
+    if (from_row >= 0)
+      copy_row(out.rows(from_row, 1), dst, py, true);
   }
-  ofs << "px,py,x,y\n";
-  for (const auto &r : data) {
-    ofs << r.px << ',' << r.py << ',' << r.x << ',' << r.y << '\n';
+  return reused;
+}
+
+void compute_grid_streaming(const Params &p, const RowSink &sink,
+                            int ring_bands) {
+  ThreadPool pool(resolve_threads(p.threads));
+  compute_grid_streaming(p, sink, pool, ring_bands);
+}
+
+void compute_grid_streaming(const Params &p, const RowSink &sink,
+                            ThreadPool &pool, int ring_bands) {
+  compute_frames_streaming(
+      {p}, [&](std::size_t, const GridView &rows) { sink(rows); }, pool,
+      ring_bands);
+}
+
+void compute_frames_streaming(const std::vector<Params> &frames,
+                              const FrameSink &sink, int ring_bands) {
+  if (frames.empty())
+    return;
+  ThreadPool pool(resolve_threads(frames.front().threads));
+  compute_frames_streaming(frames, sink, pool, ring_bands);
+}
+
+void compute_frames_streaming(const std::vector<Params> &frames,
+                              const FrameSink &sink, ThreadPool &pool,
+                              int ring_bands) {
+  if (frames.empty())
+    return;
+
+  // Set up when its first band is launched and released after its last
+  // band is emitted. Not movable: the tile engine refers to p and k.
+  struct Frame {
+    Frame(const Params &params, std::size_t i, ThreadPool &pool)
+        : p(params), k(tile_kernels(p)), e(tile_engine(p, k)),
+          m(plan_mirror(p)), uses(m.uses),
+          bands((p.height + e.tile_h - 1) / e.tile_h), index(i) {
+      if (p.schedule == Schedule::cost)
+        costs.emplace(p, pool);
+    }
+    Frame(const Frame &) = delete;
+    Frame &operator=(const Frame &) = delete;
+
+    const Params p;
+    const TileKernels k;
+    const TileEngine e;
+    const MirrorPlan m;
+    std::optional<CostMap> costs; // Schedule::cost
+    // Computed rows that later rows mirror, kept until their last use.
+    // With center_y = 0 this is the upper half of the image.
+    std::unordered_map<int, GridResult> kept;
+    std::vector<int> uses;
+    const int bands;
+    const std::size_t index;
+  };
+  // Frames with bands in flight or still to be emitted, in order.
+  std::deque<std::unique_ptr<Frame>> live;
+  live.push_back(std::make_unique<Frame>(frames.front(), 0, pool));
+
+  if (ring_bands <= 0) {
+    // Enough tiles in flight to keep every participant busy while the
+    // owning thread is in the sink.
+    const Frame &f = *live.front();
+    const std::size_t per_band =
+        (static_cast<std::size_t>(f.p.width) + f.e.tile_w - 1) / f.e.tile_w;
+    const std::size_t want = 4 * static_cast<std::size_t>(pool.size());
+    ring_bands = static_cast<int>(
+        std::max<std::size_t>(2, (want + per_band - 1) / per_band));
   }
-  if (!ofs) {
-    throw std::runtime_error("I/O error while writing CSV: " + path);
+
+  // One band is a full-width row of tiles; the sink sees whole bands. The
+  // ring runs on across frame boundaries.
+  struct Slot {
+    GridResult rows; // rows y0.. of the band, at row 0
+    TaskPlan plan;
+    TaskGroup group;
+    ThreadPool::IndexFn fn;
+    Frame *frame = nullptr;
+    int y0 = 0;
+    int y1 = 0;
+  };
+  std::vector<std::unique_ptr<Slot>> ring;
+  for (int r = 0; r < ring_bands; ++r)
+    ring.push_back(std::make_unique<Slot>());
+
+  std::size_t next_frame = 0;
+  int next_band = 0;
+  // Launches the next band of the sequence into s; false after the last.
+  auto launch_next = [&](Slot &s) {
+    for (; next_frame < frames.size(); ++next_frame, next_band = 0) {
+      if (live.empty() || live.back()->index != next_frame)
+        live.push_back(
+            std::make_unique<Frame>(frames[next_frame], next_frame, pool));
+      Frame &f = *live.back();
+      if (next_band >= f.bands) {
+        if (f.bands == 0)
+          live.pop_back();
+        continue;
+      }
+      s.frame = &f;
+      s.y0 = next_band++ * f.e.tile_h;
+      s.y1 = std::min(s.y0 + f.e.tile_h, f.p.height);
+      s.rows.resize(f.p.width, f.e.tile_h, f.p.channels);
+      s.plan = schedule_tiles(f.p, plan_tiles(f.p, f.e, f.m, s.y0, s.y1),
+                              f.costs ? &*f.costs : nullptr, pool.size());
+      s.fn = [&f, &s, &pool](std::size_t i, int worker) {
+        const TileOut out = tile_out(s.rows, s.y0);
+        for (std::size_t t = s.plan.first[i]; t < s.plan.first[i + 1]; ++t)
+          run_tile(f.p, f.e, s.plan.tiles[t], out, pool, worker);
+      };
+      pool.submit(s.group, s.plan.tasks(), s.fn, s.plan.deal);
+      return true;
+    }
+    return false;
+  };
+
+  int in_flight = 0;
+  try {
+    while (in_flight < ring_bands &&
+           launch_next(*ring[static_cast<std::size_t>(in_flight)]))
+      ++in_flight;
+    for (std::size_t r = 0; in_flight > 0; r = (r + 1) % ring.size()) {
+      Slot &s = *ring[r];
+      pool.wait(s.group);
+      Frame &f = *s.frame;
+      const TileOut band_out = tile_out(s.rows, s.y0);
+      for (int py = s.y0; py < s.y1; ++py) {
+        const int src = f.m.source[static_cast<std::size_t>(py)];
+        if (src >= 0) {
+          auto it = f.kept.find(src);
+          copy_row(it->second.view(), band_out, py, true);
+          if (--f.uses[static_cast<std::size_t>(src)] == 0)
+            f.kept.erase(it);
+        } else if (f.uses[static_cast<std::size_t>(py)] > 0) {
+          GridResult &z = f.kept[py];
+          z.resize(f.p.width, 1, f.p.channels);
+          copy_row(s.rows.rows(py - s.y0, 1), tile_out(z, py), py, false);
+        }
+      }
+      GridView rows = s.rows.rows(0, s.y1 - s.y0);
+      rows.y0 = s.y0;
+      sink(f.index, rows);
+      if (s.y1 == f.p.height)
+        live.pop_front(); // f: its bands are emitted in order
+      --in_flight;
+      if (launch_next(s))
+        ++in_flight;
+    }
+  } catch (...) {
+    // Tasks still in flight reference the ring; let them finish first.
+    for (auto &s : ring) {
+      try {
+        pool.wait(s->group);
+      } catch (...) {
+      }
+    }
+    throw;
   }
 }
 
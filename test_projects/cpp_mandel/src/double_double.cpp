@@ -0,0 +1,85 @@
+#include "mandel/double_double.hpp"
+#include "mandel/precision.hpp"
+#include "mandel/quad_double.hpp"
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace mandel {
+
+namespace {
+
+// 10^n for n >= 0 by binary powering.
+template <class T> T pow10(int n) {
+  T result = ScalarPolicy<T>::from_double(1.0);
+  T base = ScalarPolicy<T>::from_double(10.0);
+  for (; n > 0; n >>= 1) {
+    if (n & 1)
+      result = result * base;
+    base = base * base;
+  }
+  return result;
+}
+
+template <class T> T parse_decimal(std::string_view text) {
+  using S = ScalarPolicy<T>;
+  auto fail = [&]() -> T {
+    throw std::runtime_error("Invalid decimal number: " + std::string(text));
+  };
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+    text.remove_prefix(1);
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+    text.remove_suffix(1);
+  std::size_t i = 0;
+  const std::size_t n = text.size();
+  bool negative = false;
+  if (i < n && (text[i] == '+' || text[i] == '-'))
+    negative = text[i++] == '-';
+  const T ten = S::from_double(10.0);
+  T value = S::from_double(0.0);
+  int exp10 = 0, digits = 0;
+  bool seen_point = false;
+  for (; i < n; ++i) {
+    const char c = text[i];
+    if (c == '.' && !seen_point) {
+      seen_point = true;
+    } else if (c >= '0' && c <= '9') {
+      value = value * ten + S::from_double(static_cast<double>(c - '0'));
+      ++digits;
+      if (seen_point)
+        --exp10;
+    } else {
+      break;
+    }
+  }
+  if (digits == 0)
+    return fail();
+  if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+    const std::string exp(text.substr(i + 1));
+    char *end = nullptr;
+    const long e = std::strtol(exp.c_str(), &end, 10);
+    if (exp.empty() || *end != '\0' || e < -1000 || e > 1000)
+      return fail();
+    exp10 += static_cast<int>(e);
+    i = n;
+  }
+  if (i != n)
+    return fail();
+  if (exp10 > 0)
+    value = value * pow10<T>(exp10);
+  else if (exp10 < 0 && S::to_double(value) != 0.0)
+    value = value / pow10<T>(-exp10);
+  return negative ? -value : value;
+}
+
+} // namespace
+
+DoubleDouble parse_double_double(std::string_view text) {
+  return parse_decimal<DoubleDouble>(text);
+}
+
+QuadDouble parse_quad_double(std::string_view text) {
+  return parse_decimal<QuadDouble>(text);
+}
+
+} // namespace mandel
@@ -0,0 +1,562 @@
+#include "mandel/core.hpp"
+#include "mandel/kernels.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+namespace mandel {
+
+static_assert(std::endian::native == std::endian::little,
+              "npy/raw writers store host doubles as little-endian");
+
+namespace {
+
+// Output file without stdio buffering: every write() is handed straight to
+// the OS (a single write(2) on POSIX), so callers batch data themselves.
+class OutFile {
+public:
+  explicit OutFile(const char *what) : what_(what) {}
+  OutFile(const std::string &path, const char *what) : what_(what) {
+    open(path);
+  }
+  ~OutFile() {
+    if (f_)
+      std::fclose(f_);
+  }
+  OutFile(const OutFile &) = delete;
+  OutFile &operator=(const OutFile &) = delete;
+
+  // Closes the current file, if any, without reporting errors. A path that
+  // is one of several hard links (e.g. an output fetched from a
+  // ResultCache) is unlinked first instead of being truncated in place.
+  void open(const std::string &path) {
+    if (f_)
+      std::fclose(f_);
+    path_ = path;
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(path, ec) &&
+        std::filesystem::hard_link_count(path, ec) > 1)
+      std::filesystem::remove(path, ec);
+    f_ = std::fopen(path.c_str(), "wb");
+    if (!f_)
+      throw std::runtime_error(std::string("Failed to open ") + what_ +
+                               " for writing: " + path_);
+    std::setvbuf(f_, nullptr, _IONBF, 0);
+  }
+
+  void write(const void *data, std::size_t n) {
+    if (n != 0 && std::fwrite(data, 1, n, f_) != n)
+      fail();
+  }
+
+  void write_at(std::uint64_t offset, const void *data, std::size_t n) {
+#if defined(_WIN32)
+    const int rc = _fseeki64(f_, static_cast<long long>(offset), SEEK_SET);
+#else
+    const int rc = fseeko(f_, static_cast<off_t>(offset), SEEK_SET);
+#endif
+    if (rc != 0)
+      fail();
+    write(data, n);
+  }
+
+  // Close and report errors (the destructor cannot).
+  void close() {
+    std::FILE *f = f_;
+    f_ = nullptr;
+    if (std::fclose(f) != 0)
+      fail();
+  }
+
+  const std::string &path() const { return path_; }
+
+  [[noreturn]] void fail() const {
+    throw std::runtime_error(std::string("I/O error while writing ") + what_ +
+                             ": " + path_);
+  }
+
+private:
+  std::string path_;
+  const char *what_;
+  std::FILE *f_ = nullptr;
+};
+
+// Every Channel value, for per-channel tables.
+constexpr std::size_t kChannels = 5;
+
+std::size_t index(Channel c) { return static_cast<std::size_t>(c); }
+
+// rows' array for channel c; throws if the grid was computed without it.
+template <class T>
+const T *channel_data(const T *data, Channel c) {
+  if (!data)
+    throw std::runtime_error(std::string("Grid has no ") + channel_name(c) +
+                             " channel to write");
+  return data;
+}
+
+// ---------- CSV ----------
+
+// Longest possible CSV row: two ints (11 chars each), three shortest
+// round-trip doubles (24 chars), a uint32 (10) and a flag, with room to
+// spare.
+constexpr std::size_t kMaxCsvRow = 160;
+
+template <class T> char *put(char *p, char *end, T v) {
+  const auto [q, ec] = std::to_chars(p, end, v);
+  if (ec != std::errc())
+    throw std::runtime_error("CSV formatting overflow");
+  return q;
+}
+
+// Rows are formatted straight into a reusable 1 MiB buffer that goes to
+// the OS in one write whenever it fills up.
+class CsvWriter final : public GridWriter {
+public:
+  static constexpr std::size_t kCapacity = std::size_t{1} << 20;
+
+  explicit CsvWriter(const std::string &path)
+      : file_(path, "CSV"), buf_(new char[kCapacity]) {}
+
+  void reopen(const std::string &path) override { file_.open(path); }
+
+  void begin(const Params &p) override {
+    channels_ = p.channels;
+    std::string header = "px,py";
+    for (Channel c : channels_) {
+      header += ',';
+      header += channel_name(c);
+    }
+    header += '\n';
+    header.copy(buf_.get(), header.size());
+    used_ = header.size();
+  }
+
+  void write(const GridView &rows) override {
+    for (Channel c : channels_) {
+      if (c == Channel::iterations)
+        channel_data(rows.iterations, c);
+      else if (c == Channel::escaped)
+        channel_data(rows.escaped, c);
+      else if (c == Channel::smooth)
+        channel_data(rows.smooth, c);
+    }
+    char *const end = buf_.get() + kCapacity;
+    char *p = buf_.get() + used_;
+    std::size_t i = 0;
+    for (int py = rows.y0; py < rows.y0 + rows.rows; ++py) {
+      for (int px = 0; px < rows.width; ++px, ++i) {
+        if (static_cast<std::size_t>(end - p) < kMaxCsvRow) {
+          file_.write(buf_.get(), static_cast<std::size_t>(p - buf_.get()));
+          p = buf_.get();
+        }
+        p = put(p, end, px);
+        *p++ = ',';
+        p = put(p, end, py);
+        for (Channel c : channels_) {
+          *p++ = ',';
+          switch (c) {
+          case Channel::x:
+            p = put(p, end, rows.x[i]);
+            break;
+          case Channel::y:
+            p = put(p, end, rows.y[i]);
+            break;
+          case Channel::iterations:
+            p = put(p, end, rows.iterations[i]);
+            break;
+          case Channel::escaped:
+            *p++ = rows.escaped[i] ? '1' : '0';
+            break;
+          case Channel::smooth:
+            p = put(p, end, rows.smooth[i]);
+            break;
+          }
+        }
+        *p++ = '\n';
+      }
+    }
+    used_ = static_cast<std::size_t>(p - buf_.get());
+  }
+
+  // Rows px,py,x,y of each result, in the order given (after a begin()
+  // with the default x,y channels).
+  void write(const PixelResult *data, std::size_t n) {
+    char *const end = buf_.get() + kCapacity;
+    char *p = buf_.get() + used_;
+    for (std::size_t i = 0; i < n; ++i) {
+      if (static_cast<std::size_t>(end - p) < kMaxCsvRow) {
+        file_.write(buf_.get(), static_cast<std::size_t>(p - buf_.get()));
+        p = buf_.get();
+      }
+      p = put(p, end, data[i].px);
+      *p++ = ',';
+      p = put(p, end, data[i].py);
+      *p++ = ',';
+      p = put(p, end, data[i].x);
+      *p++ = ',';
+      p = put(p, end, data[i].y);
+      *p++ = '\n';
+    }
+    used_ = static_cast<std::size_t>(p - buf_.get());
+  }
+
+  void finish() override {
+    file_.write(buf_.get(), used_);
+    used_ = 0;
+    file_.close();
+  }
+
+private:
+  OutFile file_;
+  std::unique_ptr<char[]> buf_;
+  std::size_t used_ = 0;
+  std::vector<Channel> channels_;
+};
+
+// ---------- Columnar (npy / raw) ----------
+
+// One fixed-width column of a columnar file: values are staged in a chunk
+// buffer and flushed with a positioned write to the column's next offset.
+template <class T> class Column {
+public:
+  static constexpr std::size_t kChunk = std::size_t{1} << 16; // elements
+
+  // Start over at byte `offset`; the chunk buffer is allocated once.
+  void reset(std::uint64_t offset) {
+    offset_ = offset;
+    n_ = 0;
+    buf_.resize(kChunk);
+  }
+  void push(T v, OutFile &f) {
+    buf_[n_++] = v;
+    if (n_ == kChunk)
+      flush(f);
+  }
+  // Converts from U (the npy writer stores every channel as float64).
+  template <class U> void append(const U *v, std::size_t n, OutFile &f) {
+    while (n > 0) {
+      const std::size_t m = std::min(n, kChunk - n_);
+      std::copy_n(v, m, buf_.data() + n_);
+      n_ += m;
+      v += m;
+      n -= m;
+      if (n_ == kChunk)
+        flush(f);
+    }
+  }
+  void flush(OutFile &f) {
+    if (n_ == 0)
+      return;
+    f.write_at(offset_, buf_.data(), n_ * sizeof(T));
+    offset_ += n_ * sizeof(T);
+    n_ = 0;
+  }
+
+private:
+  std::uint64_t offset_ = 0;
+  std::vector<T> buf_;
+  std::size_t n_ = 0;
+};
+
+std::string json_double(double v) {
+  char buf[32];
+  const auto [p, ec] = std::to_chars(buf, buf + sizeof buf, v);
+  return std::string(buf, ec == std::errc() ? p : buf);
+}
+
+// NumPy format 1.0 header for a C-order float64 array of shape
+// (channels, height, width), padded so the data starts on a 64-byte
+// boundary.
+std::string npy_header(std::size_t channels, int width, int height) {
+  std::string dict = "{'descr': '<f8', 'fortran_order': False, 'shape': (" +
+                     std::to_string(channels) + ", " +
+                     std::to_string(height) + ", " + std::to_string(width) +
+                     "), }";
+  const std::size_t prefix = 10; // magic(6) + version(2) + header_len(2)
+  std::size_t total = prefix + dict.size() + 1;
+  total = (total + 63) / 64 * 64;
+  dict.append(total - prefix - dict.size() - 1, ' ');
+  dict.push_back('\n');
+  const auto len = static_cast<std::uint16_t>(dict.size());
+  std::string h("\x93NUMPY\x01\x00", 8);
+  h.push_back(static_cast<char>(len & 0xFF));
+  h.push_back(static_cast<char>(len >> 8));
+  return h + dict;
+}
+
+class ColumnWriter final : public GridWriter {
+public:
+  ColumnWriter(OutputFormat format, const std::string &path,
+               const WriterOptions &opts)
+      : format_(format), opts_(opts),
+        file_(path, format == OutputFormat::npy ? "NPY" : "raw output") {}
+
+  void reopen(const std::string &path) override { file_.open(path); }
+
+  void begin(const Params &p) override {
+    p_ = p;
+    const std::uint64_t n = static_cast<std::uint64_t>(p.width) *
+                            static_cast<std::uint64_t>(p.height);
+    std::uint64_t offset = 0;
+    if (format_ == OutputFormat::npy) {
+      const std::string h = npy_header(p.channels.size(), p.width, p.height);
+      file_.write(h.data(), h.size());
+      offset = h.size();
+    }
+    for (Channel c : p.channels) {
+      offset_[index(c)] = offset;
+      const std::size_t size = dtype_size(c);
+      if (size == 4)
+        u4_.reset(offset);
+      else if (size == 1)
+        u1_.reset(offset);
+      else
+        f8_[index(c)].reset(offset);
+      // Keep the next column 8-byte aligned after narrow ones.
+      offset = (offset + size * n + 7) / 8 * 8;
+    }
+    coords_offset_ = offset;
+    if (opts_.coords) {
+      px_.reset(offset);
+      py_.reset(offset + 4 * n);
+    }
+  }
+
+  void write(const GridView &rows) override {
+    const std::size_t n = rows.size();
+    for (Channel c : p_.channels) {
+      Column<double> &f8 = f8_[index(c)];
+      switch (c) {
+      case Channel::x:
+        f8.append(rows.x, n, file_);
+        break;
+      case Channel::y:
+        f8.append(rows.y, n, file_);
+        break;
+      case Channel::iterations:
+        if (format_ == OutputFormat::raw)
+          u4_.append(channel_data(rows.iterations, c), n, file_);
+        else
+          f8.append(channel_data(rows.iterations, c), n, file_);
+        break;
+      case Channel::escaped:
+        if (format_ == OutputFormat::raw)
+          u1_.append(channel_data(rows.escaped, c), n, file_);
+        else
+          f8.append(channel_data(rows.escaped, c), n, file_);
+        break;
+      case Channel::smooth:
+        f8.append(channel_data(rows.smooth, c), n, file_);
+        break;
+      }
+    }
+    if (opts_.coords) {
+      for (int py = rows.y0; py < rows.y0 + rows.rows; ++py) {
+        for (int px = 0; px < rows.width; ++px) {
+          px_.push(px, file_);
+          py_.push(py, file_);
+        }
+      }
+    }
+  }
+
+  void finish() override {
+    for (Column<double> &f8 : f8_)
+      f8.flush(file_);
+    u4_.flush(file_);
+    u1_.flush(file_);
+    if (opts_.coords) {
+      px_.flush(file_);
+      py_.flush(file_);
+    }
+    file_.close();
+    if (format_ == OutputFormat::raw)
+      write_sidecar();
+  }
+
+private:
+  // Bytes per value of channel c in this format.
+  std::size_t dtype_size(Channel c) const {
+    if (format_ == OutputFormat::raw && c == Channel::iterations)
+      return 4;
+    if (format_ == OutputFormat::raw && c == Channel::escaped)
+      return 1;
+    return 8;
+  }
+
+  // <path>.json describing the raw columns, for np.memmap(path, dtype,
+  // offset=..., shape=...).
+  void write_sidecar() const {
+    const std::uint64_t n = static_cast<std::uint64_t>(p_.width) *
+                            static_cast<std::uint64_t>(p_.height);
+    const std::string shape = std::to_string(p_.height) + ", " +
+                              std::to_string(p_.width);
+    std::string js;
+    auto column = [&](const char *name, const char *dtype,
+                      std::uint64_t offset) {
+      js += "    {\"name\": \"";
+      js += name;
+      js += "\", \"dtype\": \"";
+      js += dtype;
+      js += "\", \"offset\": " + std::to_string(offset);
+      js += ", \"shape\": [" + shape + "]}";
+    };
+    js += "{\n  \"format\": \"mandel-raw\",\n  \"version\": 1,\n";
+    js += "  \"byte_order\": \"little\",\n";
+    js += "  \"width\": " + std::to_string(p_.width) + ",\n";
+    js += "  \"height\": " + std::to_string(p_.height) + ",\n";
+    js += "  \"params\": {\"center_x\": " + json_double(p_.center_x);
+    js += ", \"center_y\": " + json_double(p_.center_y);
+    js += ", \"scale\": " + json_double(p_.scale);
+    js += ", \"max_iters\": " + std::to_string(p_.max_iters);
+    // Enough to tell whether the grid can seed compute_grid_incremental().
+    js += std::string(", \"precision\": \"") + precision_name(p_.precision);
+    js += std::string("\", \"engine\": \"") + engine_name(p_.engine);
+    js += std::string("\", \"fill\": \"") + fill_name(p_.fill);
+    js += std::string("\", \"interior\": \"") + interior_name(p_.interior);
+    js += "\", \"cycle_tol\": " + json_double(p_.cycle_tol) + "},\n";
+    js += "  \"columns\": [\n";
+    for (std::size_t k = 0; k < p_.channels.size(); ++k) {
+      const Channel c = p_.channels[k];
+      const std::size_t size = dtype_size(c);
+      if (k > 0)
+        js += ",\n";
+      column(channel_name(c),
+             size == 4   ? "<u4"
+             : size == 1 ? "|u1"
+                         : "<f8",
+             offset_[index(c)]);
+    }
+    if (opts_.coords) {
+      js += ",\n";
+      column("px", "<i4", coords_offset_);
+      js += ",\n";
+      column("py", "<i4", coords_offset_ + 4 * n);
+    }
+    js += "\n  ]\n}\n";
+    OutFile side(file_.path() + ".json", "raw sidecar");
+    side.write(js.data(), js.size());
+    side.close();
+  }
+
+  OutputFormat format_;
+  WriterOptions opts_;
+  OutFile file_;
+  Params p_;
+  // Per channel (indexed by Channel); raw keeps iterations and escaped in
+  // their own dtypes.
+  std::uint64_t offset_[kChannels] = {};
+  std::uint64_t coords_offset_ = 0;
+  Column<double> f8_[kChannels];
+  Column<std::uint32_t> u4_;
+  Column<std::uint8_t> u1_;
+  Column<std::int32_t> px_, py_;
+};
+
+} // namespace
+
+const char *format_name(OutputFormat f) {
+  switch (f) {
+  case OutputFormat::csv:
+    return "csv";
+  case OutputFormat::npy:
+    return "npy";
+  case OutputFormat::raw:
+    return "raw";
+  }
+  return "?";
+}
+
+OutputFormat parse_format(const std::string &name) {
+  for (OutputFormat f :
+       {OutputFormat::csv, OutputFormat::npy, OutputFormat::raw}) {
+    if (name == format_name(f))
+      return f;
+  }
+  throw std::runtime_error("Unknown output format: " + name +
+                           " (expected csv, npy, raw)");
+}
+
+const char *channel_name(Channel c) {
+  switch (c) {
+  case Channel::x:
+    return "x";
+  case Channel::y:
+    return "y";
+  case Channel::iterations:
+    return "it";
+  case Channel::escaped:
+    return "escaped";
+  case Channel::smooth:
+    return "smooth";
+  }
+  return "?";
+}
+
+std::vector<Channel> parse_channels(const std::string &list) {
+  std::vector<Channel> channels;
+  std::string_view rest(list);
+  while (true) {
+    const std::size_t comma = rest.find(',');
+    const std::string_view name = rest.substr(0, comma);
+    bool found = false;
+    for (Channel c : {Channel::x, Channel::y, Channel::iterations,
+                      Channel::escaped, Channel::smooth}) {
+      if (name != channel_name(c))
+        continue;
+      if (has_channel(channels, c))
+        throw std::runtime_error("Channel listed twice: " + std::string(name));
+      channels.push_back(c);
+      found = true;
+    }
+    if (!found)
+      throw std::runtime_error("Unknown channel: " + std::string(name) +
+                               " (expected x, y, it, escaped, smooth)");
+    if (comma == std::string_view::npos)
+      break;
+    rest.remove_prefix(comma + 1);
+  }
+  return channels;
+}
+
+std::unique_ptr<GridWriter> make_writer(OutputFormat format,
+                                        const std::string &path,
+                                        const WriterOptions &opts) {
+  if (opts.coords && format == OutputFormat::npy)
+    throw std::runtime_error(
+        "npy output keeps px/py implicit; use --format raw for coordinates");
+  if (format == OutputFormat::csv)
+    return std::make_unique<CsvWriter>(path);
+  return std::make_unique<ColumnWriter>(format, path, opts);
+}
+
+void write_grid(GridWriter &w, const Params &p, const GridResult &data) {
+  w.begin(p);
+  w.write(data.view());
+  w.finish();
+}
+
+void write_csv(const std::string &path, const GridResult &data) {
+  CsvWriter w(path);
+  w.begin(Params{});
+  w.write(data.view());
+  w.finish();
+}
+
+void write_csv(const std::string &path, const std::vector<PixelResult> &data) {
+  CsvWriter w(path);
+  w.begin(Params{});
+  w.write(data.data(), data.size());
+  w.finish();
+}
+
+} // namespace mandel
@@ -0,0 +1,297 @@
+// Compiled with AVX2 enabled (see CMakeLists.txt); only reached through
+// kernel_fn() after CPUID confirmed support.
+#include "mandel/kernels.hpp"
+#include <immintrin.h>
+
+namespace mandel::detail {
+
+namespace {
+
+enum class Cycles { off, exact, tolerance };
+
+// Scalar tail of a lane whose orbit was found to be periodic: advance by
+// `steps` plain iterations. Kept local to this file (instead of sharing an
+// inline helper) so no AVX code can leak into other translation units.
+void advance(double &zr, double &zi, double cx, double cy, long long steps) {
+  for (; steps > 0; --steps) {
+    const double zr2 = zr * zr - zi * zi + cx;
+    const double zi2 = 2.0 * zr * zi + cy;
+    zr = zr2;
+    zi = zi2;
+  }
+}
+
+// Iterates 4 pixels at a time. Each lane carries its own iteration count;
+// when a lane escapes or hits max_iters its z is stored and the lane is
+// refilled with the next pixel of the queue, so lanes never idle while work
+// remains. The arithmetic mirrors mandelbrot_last_state() operation by
+// operation (no FMA), which makes the results bit-identical.
+//
+// With cycle detection each lane also runs Brent's algorithm: a saved z is
+// refreshed whenever the step counter `lam` reaches the current power of
+// two, and a lane whose z matches the saved one is on a cycle of length
+// lam + 1. It then jumps to the same phase at max_iters.
+template <Cycles C> void run(const PixelBatch &b) {
+  constexpr int kLanes = 4;
+
+  alignas(32) double zr_l[kLanes] = {}, zi_l[kLanes] = {};
+  alignas(32) double cr_l[kLanes] = {}, ci_l[kLanes] = {};
+  alignas(32) double it_l[kLanes] = {};
+  alignas(32) double sr_l[kLanes] = {}, si_l[kLanes] = {};
+  alignas(32) double lam_l[kLanes] = {}, pw_l[kLanes] = {};
+  std::size_t pix[kLanes] = {};
+  std::size_t next = 0;
+  int live = 0;
+
+  // Load the next queued pixel into lane l (or retire the lane for good).
+  auto refill = [&](int l) {
+    zr_l[l] = zi_l[l] = it_l[l] = 0.0;
+    sr_l[l] = si_l[l] = lam_l[l] = 0.0;
+    pw_l[l] = 1.0;
+    if (next < b.n) {
+      pix[l] = next++;
+      cr_l[l] = b.cx[pix[l]];
+      ci_l[l] = b.cy[pix[l]];
+      live |= 1 << l;
+    } else {
+      cr_l[l] = ci_l[l] = 0.0;
+      live &= ~(1 << l);
+    }
+  };
+  for (int l = 0; l < kLanes; ++l)
+    refill(l);
+
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d max_it = _mm256_set1_pd(static_cast<double>(b.max_iters));
+  const __m256d tol = _mm256_set1_pd(b.cycle_tol);
+  const __m256d abs_mask =
+      _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+
+  __m256d zr = _mm256_load_pd(zr_l), zi = _mm256_load_pd(zi_l);
+  __m256d cr = _mm256_load_pd(cr_l), ci = _mm256_load_pd(ci_l);
+  __m256d it = _mm256_load_pd(it_l);
+  __m256d sr = _mm256_load_pd(sr_l), si = _mm256_load_pd(si_l);
+  __m256d lam = _mm256_load_pd(lam_l), pw = _mm256_load_pd(pw_l);
+
+  auto spill = [&] {
+    _mm256_store_pd(zr_l, zr);
+    _mm256_store_pd(zi_l, zi);
+    _mm256_store_pd(cr_l, cr);
+    _mm256_store_pd(ci_l, ci);
+    _mm256_store_pd(it_l, it);
+    _mm256_store_pd(sr_l, sr);
+    _mm256_store_pd(si_l, si);
+    _mm256_store_pd(lam_l, lam);
+    _mm256_store_pd(pw_l, pw);
+  };
+  auto reload = [&] {
+    zr = _mm256_load_pd(zr_l);
+    zi = _mm256_load_pd(zi_l);
+    cr = _mm256_load_pd(cr_l);
+    ci = _mm256_load_pd(ci_l);
+    it = _mm256_load_pd(it_l);
+    sr = _mm256_load_pd(sr_l);
+    si = _mm256_load_pd(si_l);
+    lam = _mm256_load_pd(lam_l);
+    pw = _mm256_load_pd(pw_l);
+  };
+
+  while (live != 0) {
+    const __m256d zr2 = _mm256_mul_pd(zr, zr);
+    const __m256d zi2 = _mm256_mul_pd(zi, zi);
+    const __m256d mag = _mm256_add_pd(zr2, zi2);
+    const __m256d run = _mm256_and_pd(_mm256_cmp_pd(mag, four, _CMP_LE_OQ),
+                                      _mm256_cmp_pd(it, max_it, _CMP_LT_OQ));
+    const int running = _mm256_movemask_pd(run) & live;
+    if (running != live) {
+      spill();
+      for (int l = 0; l < kLanes; ++l) {
+        if ((live & ~running) & (1 << l)) {
+          b.zx[pix[l]] = zr_l[l];
+          b.zy[pix[l]] = zi_l[l];
+          if (b.iters)
+            b.iters[pix[l]] = static_cast<std::uint32_t>(it_l[l]);
+          refill(l);
+        }
+      }
+      reload();
+      continue; // refilled lanes start over with the bailout test
+    }
+    // zi' = 2*zr*zi + ci and zr' = zr^2 - zi^2 + cr, same order as scalar.
+    zi = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(two, zr), zi), ci);
+    zr = _mm256_add_pd(_mm256_sub_pd(zr2, zi2), cr);
+    it = _mm256_add_pd(it, one);
+    if constexpr (C != Cycles::off) {
+      __m256d same;
+      if constexpr (C == Cycles::exact) {
+        // Bit patterns, not ==: +0 and -0 must not be treated as equal.
+        const __m256i eq_r = _mm256_cmpeq_epi64(_mm256_castpd_si256(zr),
+                                                _mm256_castpd_si256(sr));
+        const __m256i eq_i = _mm256_cmpeq_epi64(_mm256_castpd_si256(zi),
+                                                _mm256_castpd_si256(si));
+        same = _mm256_castsi256_pd(_mm256_and_si256(eq_r, eq_i));
+      } else {
+        const __m256d dr = _mm256_and_pd(_mm256_sub_pd(zr, sr), abs_mask);
+        const __m256d di = _mm256_and_pd(_mm256_sub_pd(zi, si), abs_mask);
+        same = _mm256_and_pd(_mm256_cmp_pd(dr, tol, _CMP_LE_OQ),
+                             _mm256_cmp_pd(di, tol, _CMP_LE_OQ));
+      }
+      const int cycled = _mm256_movemask_pd(same) & live;
+      // Advance Brent's counters for every lane before retiring any, so the
+      // surviving lanes stay in step with their iteration count.
+      lam = _mm256_add_pd(lam, one);
+      alignas(32) double period_l[kLanes];
+      if (cycled != 0)
+        _mm256_store_pd(period_l, lam);
+      const __m256d upd = _mm256_cmp_pd(lam, pw, _CMP_EQ_OQ);
+      sr = _mm256_blendv_pd(sr, zr, upd);
+      si = _mm256_blendv_pd(si, zi, upd);
+      pw = _mm256_blendv_pd(pw, _mm256_add_pd(pw, pw), upd);
+      lam = _mm256_andnot_pd(upd, lam);
+      if (cycled != 0) {
+        spill();
+        for (int l = 0; l < kLanes; ++l) {
+          if (cycled & (1 << l)) {
+            const auto left = static_cast<long long>(b.max_iters - it_l[l]);
+            const auto period = static_cast<long long>(period_l[l]);
+            advance(zr_l[l], zi_l[l], cr_l[l], ci_l[l], left % period);
+            b.zx[pix[l]] = zr_l[l];
+            b.zy[pix[l]] = zi_l[l];
+            if (b.iters)
+              b.iters[pix[l]] = static_cast<std::uint32_t>(b.max_iters);
+            refill(l);
+          }
+        }
+        reload();
+      }
+    }
+  }
+}
+
+} // namespace
+
+void avx2_kernel(const PixelBatch &b) {
+  if (b.cycle_tol < 0.0)
+    run<Cycles::off>(b);
+  else if (b.cycle_tol == 0.0)
+    run<Cycles::exact>(b);
+  else
+    run<Cycles::tolerance>(b);
+}
+
+// interior_exact_kernel() with 4-wide vectors: no bailout test, so four
+// independent orbit groups are interleaved to hide the multiply latency.
+void avx2_interior_kernel(const PixelBatch &b) {
+  constexpr std::size_t kLanes = 4;
+  constexpr std::size_t kChunk = 4 * kLanes;
+  const __m256d two = _mm256_set1_pd(2.0);
+  for (std::size_t base = 0; base < b.n; base += kChunk) {
+    alignas(32) double cr_l[kChunk] = {}, ci_l[kChunk] = {};
+    const std::size_t m = b.n - base < kChunk ? b.n - base : kChunk;
+    for (std::size_t i = 0; i < m; ++i) {
+      cr_l[i] = b.cx[base + i];
+      ci_l[i] = b.cy[base + i];
+    }
+    __m256d cr[4], ci[4], zr[4], zi[4];
+    for (std::size_t g = 0; g < 4; ++g) {
+      cr[g] = _mm256_load_pd(cr_l + g * kLanes);
+      ci[g] = _mm256_load_pd(ci_l + g * kLanes);
+      zr[g] = zi[g] = _mm256_setzero_pd();
+    }
+    for (int it = 0; it < b.max_iters; ++it) {
+      for (std::size_t g = 0; g < 4; ++g) {
+        const __m256d zr2 = _mm256_mul_pd(zr[g], zr[g]);
+        const __m256d zi2 = _mm256_mul_pd(zi[g], zi[g]);
+        zi[g] = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(two, zr[g]), zi[g]),
+                              ci[g]);
+        zr[g] = _mm256_add_pd(_mm256_sub_pd(zr2, zi2), cr[g]);
+      }
+    }
+    for (std::size_t g = 0; g < 4; ++g) {
+      _mm256_store_pd(cr_l + g * kLanes, zr[g]);
+      _mm256_store_pd(ci_l + g * kLanes, zi[g]);
+    }
+    for (std::size_t i = 0; i < m; ++i) {
+      b.zx[base + i] = cr_l[i];
+      b.zy[base + i] = ci_l[i];
+    }
+  }
+}
+
+// Precision::f32: the escape loop of run<Cycles::off> with 8 float lanes.
+// Iteration counts are kept as int32 lanes, since a float counter would
+// stop being exact at 2^24.
+void avx2_kernel_f32(const PixelBatchF32 &b) {
+  constexpr int kLanes = 8;
+
+  alignas(32) float zr_l[kLanes] = {}, zi_l[kLanes] = {};
+  alignas(32) float cr_l[kLanes] = {}, ci_l[kLanes] = {};
+  alignas(32) int it_l[kLanes] = {};
+  std::size_t pix[kLanes] = {};
+  std::size_t next = 0;
+  int live = 0;
+
+  auto refill = [&](int l) {
+    zr_l[l] = zi_l[l] = 0.0f;
+    it_l[l] = 0;
+    if (next < b.n) {
+      pix[l] = next++;
+      cr_l[l] = b.cx[pix[l]];
+      ci_l[l] = b.cy[pix[l]];
+      live |= 1 << l;
+    } else {
+      cr_l[l] = ci_l[l] = 0.0f;
+      live &= ~(1 << l);
+    }
+  };
+  for (int l = 0; l < kLanes; ++l)
+    refill(l);
+
+  const __m256 four = _mm256_set1_ps(4.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i max_it = _mm256_set1_epi32(b.max_iters);
+
+  __m256 zr = _mm256_load_ps(zr_l), zi = _mm256_load_ps(zi_l);
+  __m256 cr = _mm256_load_ps(cr_l), ci = _mm256_load_ps(ci_l);
+  __m256i it = _mm256_load_si256(reinterpret_cast<const __m256i *>(it_l));
+
+  while (live != 0) {
+    const __m256 zr2 = _mm256_mul_ps(zr, zr);
+    const __m256 zi2 = _mm256_mul_ps(zi, zi);
+    const __m256 mag = _mm256_add_ps(zr2, zi2);
+    const __m256 more = _mm256_castsi256_ps(_mm256_cmpgt_epi32(max_it, it));
+    const __m256 run =
+        _mm256_and_ps(_mm256_cmp_ps(mag, four, _CMP_LE_OQ), more);
+    const int running = _mm256_movemask_ps(run) & live;
+    if (running != live) {
+      _mm256_store_ps(zr_l, zr);
+      _mm256_store_ps(zi_l, zi);
+      _mm256_store_ps(cr_l, cr);
+      _mm256_store_ps(ci_l, ci);
+      _mm256_store_si256(reinterpret_cast<__m256i *>(it_l), it);
+      for (int l = 0; l < kLanes; ++l) {
+        if ((live & ~running) & (1 << l)) {
+          b.zx[pix[l]] = zr_l[l];
+          b.zy[pix[l]] = zi_l[l];
+          if (b.iters)
+            b.iters[pix[l]] = static_cast<std::uint32_t>(it_l[l]);
+          refill(l);
+        }
+      }
+      zr = _mm256_load_ps(zr_l);
+      zi = _mm256_load_ps(zi_l);
+      cr = _mm256_load_ps(cr_l);
+      ci = _mm256_load_ps(ci_l);
+      it = _mm256_load_si256(reinterpret_cast<const __m256i *>(it_l));
+      continue;
+    }
+    zi = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(two, zr), zi), ci);
+    zr = _mm256_add_ps(_mm256_sub_ps(zr2, zi2), cr);
+    it = _mm256_add_epi32(it, one);
+  }
+}
+
+} // namespace mandel::detail
@@ -0,0 +1,281 @@
+// Compiled with AVX-512F enabled (see CMakeLists.txt); only reached through
+// kernel_fn() after CPUID confirmed support.
+#include "mandel/kernels.hpp"
+#include <immintrin.h>
+
+namespace mandel::detail {
+
+namespace {
+
+enum class Cycles { off, exact, tolerance };
+
+// See kernel_avx2.cpp: local copy so no AVX-512 code leaks elsewhere.
+void advance(double &zr, double &zi, double cx, double cy, long long steps) {
+  for (; steps > 0; --steps) {
+    const double zr2 = zr * zr - zi * zi + cx;
+    const double zi2 = 2.0 * zr * zi + cy;
+    zr = zr2;
+    zi = zi2;
+  }
+}
+
+// 8-lane variant of the AVX2 kernel; see there for the lane refill scheme
+// and the per-lane Brent cycle detection. Comparisons produce k-masks
+// directly, so no movemask is needed.
+template <Cycles C> void run(const PixelBatch &b) {
+  constexpr int kLanes = 8;
+
+  alignas(64) double zr_l[kLanes] = {}, zi_l[kLanes] = {};
+  alignas(64) double cr_l[kLanes] = {}, ci_l[kLanes] = {};
+  alignas(64) double it_l[kLanes] = {};
+  alignas(64) double sr_l[kLanes] = {}, si_l[kLanes] = {};
+  alignas(64) double lam_l[kLanes] = {}, pw_l[kLanes] = {};
+  std::size_t pix[kLanes] = {};
+  std::size_t next = 0;
+  unsigned live = 0;
+
+  auto refill = [&](int l) {
+    zr_l[l] = zi_l[l] = it_l[l] = 0.0;
+    sr_l[l] = si_l[l] = lam_l[l] = 0.0;
+    pw_l[l] = 1.0;
+    if (next < b.n) {
+      pix[l] = next++;
+      cr_l[l] = b.cx[pix[l]];
+      ci_l[l] = b.cy[pix[l]];
+      live |= 1u << l;
+    } else {
+      cr_l[l] = ci_l[l] = 0.0;
+      live &= ~(1u << l);
+    }
+  };
+  for (int l = 0; l < kLanes; ++l)
+    refill(l);
+
+  const __m512d four = _mm512_set1_pd(4.0);
+  const __m512d two = _mm512_set1_pd(2.0);
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d max_it = _mm512_set1_pd(static_cast<double>(b.max_iters));
+  const __m512d tol = _mm512_set1_pd(b.cycle_tol);
+
+  __m512d zr = _mm512_load_pd(zr_l), zi = _mm512_load_pd(zi_l);
+  __m512d cr = _mm512_load_pd(cr_l), ci = _mm512_load_pd(ci_l);
+  __m512d it = _mm512_load_pd(it_l);
+  __m512d sr = _mm512_load_pd(sr_l), si = _mm512_load_pd(si_l);
+  __m512d lam = _mm512_load_pd(lam_l), pw = _mm512_load_pd(pw_l);
+
+  auto spill = [&] {
+    _mm512_store_pd(zr_l, zr);
+    _mm512_store_pd(zi_l, zi);
+    _mm512_store_pd(cr_l, cr);
+    _mm512_store_pd(ci_l, ci);
+    _mm512_store_pd(it_l, it);
+    _mm512_store_pd(sr_l, sr);
+    _mm512_store_pd(si_l, si);
+    _mm512_store_pd(lam_l, lam);
+    _mm512_store_pd(pw_l, pw);
+  };
+  auto reload = [&] {
+    zr = _mm512_load_pd(zr_l);
+    zi = _mm512_load_pd(zi_l);
+    cr = _mm512_load_pd(cr_l);
+    ci = _mm512_load_pd(ci_l);
+    it = _mm512_load_pd(it_l);
+    sr = _mm512_load_pd(sr_l);
+    si = _mm512_load_pd(si_l);
+    lam = _mm512_load_pd(lam_l);
+    pw = _mm512_load_pd(pw_l);
+  };
+
+  while (live != 0) {
+    const __m512d zr2 = _mm512_mul_pd(zr, zr);
+    const __m512d zi2 = _mm512_mul_pd(zi, zi);
+    const __m512d mag = _mm512_add_pd(zr2, zi2);
+    const unsigned running =
+        static_cast<unsigned>(_mm512_cmp_pd_mask(mag, four, _CMP_LE_OQ) &
+                              _mm512_cmp_pd_mask(it, max_it, _CMP_LT_OQ)) &
+        live;
+    if (running != live) {
+      spill();
+      for (int l = 0; l < kLanes; ++l) {
+        if ((live & ~running) & (1u << l)) {
+          b.zx[pix[l]] = zr_l[l];
+          b.zy[pix[l]] = zi_l[l];
+          if (b.iters)
+            b.iters[pix[l]] = static_cast<std::uint32_t>(it_l[l]);
+          refill(l);
+        }
+      }
+      reload();
+      continue;
+    }
+    zi = _mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(two, zr), zi), ci);
+    zr = _mm512_add_pd(_mm512_sub_pd(zr2, zi2), cr);
+    it = _mm512_add_pd(it, one);
+    if constexpr (C != Cycles::off) {
+      __mmask8 same;
+      if constexpr (C == Cycles::exact) {
+        same = _mm512_cmpeq_epi64_mask(_mm512_castpd_si512(zr),
+                                       _mm512_castpd_si512(sr)) &
+               _mm512_cmpeq_epi64_mask(_mm512_castpd_si512(zi),
+                                       _mm512_castpd_si512(si));
+      } else {
+        same = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(zr, sr)), tol,
+                                  _CMP_LE_OQ) &
+               _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(zi, si)), tol,
+                                  _CMP_LE_OQ);
+      }
+      const unsigned cycled = static_cast<unsigned>(same) & live;
+      // Advance Brent's counters for every lane before retiring any, so the
+      // surviving lanes stay in step with their iteration count.
+      lam = _mm512_add_pd(lam, one);
+      alignas(64) double period_l[kLanes];
+      if (cycled != 0)
+        _mm512_store_pd(period_l, lam);
+      const __mmask8 upd = _mm512_cmp_pd_mask(lam, pw, _CMP_EQ_OQ);
+      sr = _mm512_mask_blend_pd(upd, sr, zr);
+      si = _mm512_mask_blend_pd(upd, si, zi);
+      pw = _mm512_mask_blend_pd(upd, pw, _mm512_add_pd(pw, pw));
+      lam = _mm512_mask_blend_pd(upd, lam, _mm512_setzero_pd());
+      if (cycled != 0) {
+        spill();
+        for (int l = 0; l < kLanes; ++l) {
+          if (cycled & (1u << l)) {
+            const auto left = static_cast<long long>(b.max_iters - it_l[l]);
+            const auto period = static_cast<long long>(period_l[l]);
+            advance(zr_l[l], zi_l[l], cr_l[l], ci_l[l], left % period);
+            b.zx[pix[l]] = zr_l[l];
+            b.zy[pix[l]] = zi_l[l];
+            if (b.iters)
+              b.iters[pix[l]] = static_cast<std::uint32_t>(b.max_iters);
+            refill(l);
+          }
+        }
+        reload();
+      }
+    }
+  }
+}
+
+} // namespace
+
+void avx512_kernel(const PixelBatch &b) {
+  if (b.cycle_tol < 0.0)
+    run<Cycles::off>(b);
+  else if (b.cycle_tol == 0.0)
+    run<Cycles::exact>(b);
+  else
+    run<Cycles::tolerance>(b);
+}
+
+// interior_exact_kernel() with 8-wide vectors: no bailout test, so four
+// independent orbit groups are interleaved to hide the multiply latency.
+void avx512_interior_kernel(const PixelBatch &b) {
+  constexpr std::size_t kLanes = 8;
+  constexpr std::size_t kChunk = 4 * kLanes;
+  const __m512d two = _mm512_set1_pd(2.0);
+  for (std::size_t base = 0; base < b.n; base += kChunk) {
+    alignas(64) double cr_l[kChunk] = {}, ci_l[kChunk] = {};
+    const std::size_t m = b.n - base < kChunk ? b.n - base : kChunk;
+    for (std::size_t i = 0; i < m; ++i) {
+      cr_l[i] = b.cx[base + i];
+      ci_l[i] = b.cy[base + i];
+    }
+    __m512d cr[4], ci[4], zr[4], zi[4];
+    for (std::size_t g = 0; g < 4; ++g) {
+      cr[g] = _mm512_load_pd(cr_l + g * kLanes);
+      ci[g] = _mm512_load_pd(ci_l + g * kLanes);
+      zr[g] = zi[g] = _mm512_setzero_pd();
+    }
+    for (int it = 0; it < b.max_iters; ++it) {
+      for (std::size_t g = 0; g < 4; ++g) {
+        const __m512d zr2 = _mm512_mul_pd(zr[g], zr[g]);
+        const __m512d zi2 = _mm512_mul_pd(zi[g], zi[g]);
+        zi[g] = _mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(two, zr[g]), zi[g]),
+                              ci[g]);
+        zr[g] = _mm512_add_pd(_mm512_sub_pd(zr2, zi2), cr[g]);
+      }
+    }
+    for (std::size_t g = 0; g < 4; ++g) {
+      _mm512_store_pd(cr_l + g * kLanes, zr[g]);
+      _mm512_store_pd(ci_l + g * kLanes, zi[g]);
+    }
+    for (std::size_t i = 0; i < m; ++i) {
+      b.zx[base + i] = cr_l[i];
+      b.zy[base + i] = ci_l[i];
+    }
+  }
+}
+
+// 16-lane variant of avx2_kernel_f32().
+void avx512_kernel_f32(const PixelBatchF32 &b) {
+  constexpr int kLanes = 16;
+
+  alignas(64) float zr_l[kLanes] = {}, zi_l[kLanes] = {};
+  alignas(64) float cr_l[kLanes] = {}, ci_l[kLanes] = {};
+  alignas(64) int it_l[kLanes] = {};
+  std::size_t pix[kLanes] = {};
+  std::size_t next = 0;
+  unsigned live = 0;
+
+  auto refill = [&](int l) {
+    zr_l[l] = zi_l[l] = 0.0f;
+    it_l[l] = 0;
+    if (next < b.n) {
+      pix[l] = next++;
+      cr_l[l] = b.cx[pix[l]];
+      ci_l[l] = b.cy[pix[l]];
+      live |= 1u << l;
+    } else {
+      cr_l[l] = ci_l[l] = 0.0f;
+      live &= ~(1u << l);
+    }
+  };
+  for (int l = 0; l < kLanes; ++l)
+    refill(l);
+
+  const __m512 four = _mm512_set1_ps(4.0f);
+  const __m512 two = _mm512_set1_ps(2.0f);
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i max_it = _mm512_set1_epi32(b.max_iters);
+
+  __m512 zr = _mm512_load_ps(zr_l), zi = _mm512_load_ps(zi_l);
+  __m512 cr = _mm512_load_ps(cr_l), ci = _mm512_load_ps(ci_l);
+  __m512i it = _mm512_load_si512(it_l);
+
+  while (live != 0) {
+    const __m512 zr2 = _mm512_mul_ps(zr, zr);
+    const __m512 zi2 = _mm512_mul_ps(zi, zi);
+    const __m512 mag = _mm512_add_ps(zr2, zi2);
+    const unsigned running =
+        static_cast<unsigned>(_mm512_cmp_ps_mask(mag, four, _CMP_LE_OQ) &
+                              _mm512_cmplt_epi32_mask(it, max_it)) &
+        live;
+    if (running != live) {
+      _mm512_store_ps(zr_l, zr);
+      _mm512_store_ps(zi_l, zi);
+      _mm512_store_ps(cr_l, cr);
+      _mm512_store_ps(ci_l, ci);
+      _mm512_store_si512(it_l, it);
+      for (int l = 0; l < kLanes; ++l) {
+        if ((live & ~running) & (1u << l)) {
+          b.zx[pix[l]] = zr_l[l];
+          b.zy[pix[l]] = zi_l[l];
+          if (b.iters)
+            b.iters[pix[l]] = static_cast<std::uint32_t>(it_l[l]);
+          refill(l);
+        }
+      }
+      zr = _mm512_load_ps(zr_l);
+      zi = _mm512_load_ps(zi_l);
+      cr = _mm512_load_ps(cr_l);
+      ci = _mm512_load_ps(ci_l);
+      it = _mm512_load_si512(it_l);
+      continue;
+    }
+    zi = _mm512_add_ps(_mm512_mul_ps(_mm512_mul_ps(two, zr), zi), ci);
+    zr = _mm512_add_ps(_mm512_sub_ps(zr2, zi2), cr);
+    it = _mm512_add_epi32(it, one);
+  }
+}
+
+} // namespace mandel::detail
@@ -0,0 +1,429 @@
+#include "mandel/kernels.hpp"
+#include "mandel/precision.hpp"
+#include <algorithm>
+#include <complex>
+#include <stdexcept>
+#include <string>
+
+#if defined(MANDEL_HAVE_X86_KERNELS)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace mandel {
+
+#if defined(MANDEL_HAVE_X86_KERNELS)
+namespace detail {
+// Defined in kernel_avx2.cpp / kernel_avx512.cpp, which are the only
+// translation units compiled with the matching -m / /arch flags.
+void avx2_kernel(const PixelBatch &b);
+void avx512_kernel(const PixelBatch &b);
+void avx2_interior_kernel(const PixelBatch &b);
+void avx512_interior_kernel(const PixelBatch &b);
+void avx2_kernel_f32(const PixelBatchF32 &b);
+void avx512_kernel_f32(const PixelBatchF32 &b);
+} // namespace detail
+#endif
+
+namespace {
+
+struct CpuFeatures {
+  bool avx2 = false;
+  bool avx512f = false;
+};
+
+#if defined(MANDEL_HAVE_X86_KERNELS)
+void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+  int r[4];
+  __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+  for (int i = 0; i < 4; ++i)
+    regs[i] = static_cast<unsigned>(r[i]);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0: which register states the OS saves on context switch.
+unsigned long long xgetbv0() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  unsigned eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+}
+
+CpuFeatures detect_cpu() {
+  CpuFeatures f;
+  unsigned r[4];
+  cpuid(0, 0, r);
+  const unsigned max_leaf = r[0];
+  if (max_leaf < 7)
+    return f;
+  cpuid(1, 0, r);
+  const bool osxsave = (r[2] & (1u << 27)) != 0;
+  const bool avx = (r[2] & (1u << 28)) != 0;
+  if (!osxsave || !avx)
+    return f;
+  const unsigned long long xcr0 = xgetbv0();
+  const bool ymm_state = (xcr0 & 0x6) == 0x6;   // SSE + AVX
+  const bool zmm_state = (xcr0 & 0xE0) == 0xE0; // opmask + ZMM0-31
+  cpuid(7, 0, r);
+  f.avx2 = ymm_state && (r[1] & (1u << 5)) != 0;
+  f.avx512f = ymm_state && zmm_state && (r[1] & (1u << 16)) != 0;
+  return f;
+}
+#else
+CpuFeatures detect_cpu() { return {}; }
+#endif
+
+// Probed once, on first use.
+const CpuFeatures &cpu() {
+  static const CpuFeatures f = detect_cpu();
+  return f;
+}
+
+} // namespace
+
+void scalar_kernel(const PixelBatch &b) {
+  for (std::size_t i = 0; i < b.n; ++i) {
+    int it = 0;
+    auto [zr, zi] = mandelbrot_last_state_periodic(
+        b.cx[i], b.cy[i], b.max_iters, b.cycle_tol, b.iters ? &it : nullptr);
+    b.zx[i] = zr;
+    b.zy[i] = zi;
+    if (b.iters)
+      b.iters[i] = static_cast<std::uint32_t>(it);
+  }
+}
+
+void scalar_kernel_f32(const PixelBatchF32 &b) {
+  for (std::size_t i = 0; i < b.n; ++i) {
+    int it = 0;
+    auto [zr, zi] = last_state<float>(b.cx[i], b.cy[i], b.max_iters,
+                                      b.iters ? &it : nullptr);
+    b.zx[i] = static_cast<float>(zr);
+    b.zy[i] = static_cast<float>(zi);
+    if (b.iters)
+      b.iters[i] = static_cast<std::uint32_t>(it);
+  }
+}
+
+template <int K> void unrolled_kernel(const PixelBatch &b) {
+  if (b.cycle_tol >= 0.0) {
+    scalar_kernel(b);
+    return;
+  }
+  for (std::size_t i = 0; i < b.n; ++i) {
+    const double cr = b.cx[i], ci = b.cy[i];
+    double zr = 0.0, zi = 0.0;
+    int it = 0;
+    auto step = [&] {
+      const double zr2 = zr * zr - zi * zi + cr;
+      const double zi2 = 2.0 * zr * zi + ci;
+      zr = zr2;
+      zi = zi2;
+    };
+    while (b.max_iters - it >= K) {
+      const double sr = zr, si = zi;
+      for (int j = 0; j < K; ++j)
+        step();
+      if (!(zr * zr + zi * zi <= 4.0)) {
+        // Escaped (or overflowed) somewhere in the block: replay it. The
+        // loop below then stops at once.
+        zr = sr;
+        zi = si;
+        for (int j = 0; j < K && zr * zr + zi * zi <= 4.0; ++j, ++it)
+          step();
+        break;
+      }
+      it += K;
+    }
+    while (it < b.max_iters && zr * zr + zi * zi <= 4.0) {
+      step();
+      ++it;
+    }
+    b.zx[i] = zr;
+    b.zy[i] = zi;
+    if (b.iters)
+      b.iters[i] = static_cast<std::uint32_t>(it);
+  }
+}
+
+template void unrolled_kernel<2>(const PixelBatch &);
+template void unrolled_kernel<4>(const PixelBatch &);
+template void unrolled_kernel<8>(const PixelBatch &);
+template void unrolled_kernel<16>(const PixelBatch &);
+
+BatchKernelFn unrolled_kernel_fn(int k) {
+  switch (k) {
+  case 1:
+    return &scalar_kernel;
+  case 2:
+    return &unrolled_kernel<2>;
+  case 4:
+    return &unrolled_kernel<4>;
+  case 8:
+    return &unrolled_kernel<8>;
+  case 16:
+    return &unrolled_kernel<16>;
+  }
+  throw std::runtime_error("Unsupported unroll factor: " + std::to_string(k) +
+                           " (expected 1, 2, 4, 8 or 16)");
+}
+
+namespace {
+
+template <class T> void interior_exact_chunks(const BasicPixelBatch<T> &b) {
+  // Fixed-width chunks with no data-dependent exit let the compiler keep
+  // several orbits in vector registers (16 doubles or 32 floats). Padding
+  // lanes iterate c = 0.
+  constexpr std::size_t kChunk = 128 / sizeof(T);
+  const T two = 2;
+  for (std::size_t base = 0; base < b.n; base += kChunk) {
+    const std::size_t m = std::min(kChunk, b.n - base);
+    T cr[kChunk] = {}, ci[kChunk] = {};
+    T zr[kChunk] = {}, zi[kChunk] = {};
+    std::copy_n(b.cx + base, m, cr);
+    std::copy_n(b.cy + base, m, ci);
+    for (int it = 0; it < b.max_iters; ++it) {
+      for (std::size_t i = 0; i < kChunk; ++i) {
+        const T zr2 = zr[i] * zr[i] - zi[i] * zi[i] + cr[i];
+        const T zi2 = two * zr[i] * zi[i] + ci[i];
+        zr[i] = zr2;
+        zi[i] = zi2;
+      }
+    }
+    std::copy_n(zr, m, b.zx + base);
+    std::copy_n(zi, m, b.zy + base);
+  }
+}
+
+} // namespace
+
+void interior_exact_kernel(const PixelBatch &b) { interior_exact_chunks(b); }
+
+void interior_exact_kernel_f32(const PixelBatchF32 &b) {
+  interior_exact_chunks(b);
+}
+
+void interior_attractor_kernel(const PixelBatch &b) {
+  for (std::size_t i = 0; i < b.n; ++i) {
+    const std::complex<double> c(b.cx[i], b.cy[i]);
+    std::complex<double> z;
+    const double xb = b.cx[i] + 1.0;
+    if (xb * xb + b.cy[i] * b.cy[i] <= 0.0625) {
+      const std::complex<double> r = std::sqrt(-3.0 - 4.0 * c);
+      z = (b.max_iters % 2 == 0) ? (-1.0 + r) / 2.0 : (-1.0 - r) / 2.0;
+    } else {
+      z = (1.0 - std::sqrt(1.0 - 4.0 * c)) / 2.0;
+    }
+    b.zx[i] = z.real();
+    b.zy[i] = z.imag();
+  }
+}
+
+bool kernel_supported(Kernel k) {
+  switch (k) {
+  case Kernel::automatic:
+  case Kernel::scalar:
+    return true;
+  case Kernel::avx2:
+    return cpu().avx2;
+  case Kernel::avx512:
+    return cpu().avx512f;
+  }
+  return false;
+}
+
+Kernel resolve_kernel(Kernel k) {
+  if (k == Kernel::automatic) {
+    if (kernel_supported(Kernel::avx512))
+      return Kernel::avx512;
+    if (kernel_supported(Kernel::avx2))
+      return Kernel::avx2;
+    return Kernel::scalar;
+  }
+  if (!kernel_supported(k))
+    throw std::runtime_error(std::string("Kernel not supported on this CPU: ") +
+                             kernel_name(k));
+  return k;
+}
+
+BatchKernelFn kernel_fn(Kernel k) {
+  switch (resolve_kernel(k)) {
+#if defined(MANDEL_HAVE_X86_KERNELS)
+  case Kernel::avx2:
+    return &detail::avx2_kernel;
+  case Kernel::avx512:
+    return &detail::avx512_kernel;
+#endif
+  default:
+    return &scalar_kernel;
+  }
+}
+
+BatchKernelFn interior_exact_fn(Kernel k) {
+  switch (resolve_kernel(k)) {
+#if defined(MANDEL_HAVE_X86_KERNELS)
+  case Kernel::avx2:
+    return &detail::avx2_interior_kernel;
+  case Kernel::avx512:
+    return &detail::avx512_interior_kernel;
+#endif
+  default:
+    return &interior_exact_kernel;
+  }
+}
+
+BatchKernelF32Fn kernel_f32_fn(Kernel k) {
+  switch (resolve_kernel(k)) {
+#if defined(MANDEL_HAVE_X86_KERNELS)
+  case Kernel::avx2:
+    return &detail::avx2_kernel_f32;
+  case Kernel::avx512:
+    return &detail::avx512_kernel_f32;
+#endif
+  default:
+    return &scalar_kernel_f32;
+  }
+}
+
+const char *kernel_name(Kernel k) {
+  switch (k) {
+  case Kernel::automatic:
+    return "auto";
+  case Kernel::scalar:
+    return "scalar";
+  case Kernel::avx2:
+    return "avx2";
+  case Kernel::avx512:
+    return "avx512";
+  }
+  return "?";
+}
+
+const char *interior_name(Interior m) {
+  switch (m) {
+  case Interior::iterate:
+    return "iterate";
+  case Interior::exact:
+    return "exact";
+  case Interior::attractor:
+    return "attractor";
+  }
+  return "?";
+}
+
+const char *engine_name(Engine e) {
+  switch (e) {
+  case Engine::grid:
+    return "grid";
+  case Engine::subdivide:
+    return "subdivide";
+  case Engine::perturbation:
+    return "perturbation";
+  }
+  return "?";
+}
+
+const char *fill_name(Fill f) {
+  switch (f) {
+  case Fill::exact:
+    return "exact";
+  case Fill::approximate:
+    return "approximate";
+  }
+  return "?";
+}
+
+const char *precision_name(Precision p) {
+  switch (p) {
+  case Precision::automatic:
+    return "auto";
+  case Precision::f32:
+    return "float";
+  case Precision::f64:
+    return "double";
+  case Precision::dd:
+    return "dd";
+  case Precision::qd:
+    return "qd";
+  }
+  return "?";
+}
+
+const char *schedule_name(Schedule s) {
+  switch (s) {
+  case Schedule::rows:
+    return "rows";
+  case Schedule::steal:
+    return "steal";
+  case Schedule::cost:
+    return "cost";
+  }
+  return "?";
+}
+
+Kernel parse_kernel(std::string_view name) {
+  for (Kernel k :
+       {Kernel::automatic, Kernel::scalar, Kernel::avx2, Kernel::avx512}) {
+    if (name == kernel_name(k))
+      return k;
+  }
+  throw std::runtime_error("Unknown kernel: " + std::string(name) +
+                           " (expected auto, scalar, avx2, avx512)");
+}
+
+Interior parse_interior(std::string_view name) {
+  for (Interior m : {Interior::iterate, Interior::exact, Interior::attractor}) {
+    if (name == interior_name(m))
+      return m;
+  }
+  throw std::runtime_error("Unknown interior mode: " + std::string(name) +
+                           " (expected iterate, exact, attractor)");
+}
+
+Engine parse_engine(std::string_view name) {
+  for (Engine e : {Engine::grid, Engine::subdivide, Engine::perturbation}) {
+    if (name == engine_name(e))
+      return e;
+  }
+  throw std::runtime_error("Unknown engine: " + std::string(name) +
+                           " (expected grid, subdivide, perturbation)");
+}
+
+Fill parse_fill(std::string_view name) {
+  for (Fill f : {Fill::exact, Fill::approximate}) {
+    if (name == fill_name(f))
+      return f;
+  }
+  throw std::runtime_error("Unknown fill policy: " + std::string(name) +
+                           " (expected exact, approximate)");
+}
+
+Precision parse_precision(std::string_view name) {
+  for (Precision p : {Precision::automatic, Precision::f32, Precision::f64,
+                      Precision::dd, Precision::qd}) {
+    if (name == precision_name(p))
+      return p;
+  }
+  throw std::runtime_error("Unknown precision: " + std::string(name) +
+                           " (expected auto, float, double, dd, qd)");
+}
+
+Schedule parse_schedule(std::string_view name) {
+  for (Schedule s : {Schedule::rows, Schedule::steal, Schedule::cost}) {
+    if (name == schedule_name(s))
+      return s;
+  }
+  throw std::runtime_error("Unknown schedule: " + std::string(name) +
+                           " (expected rows, steal, cost)");
+}
+
+} // namespace mandel
@@ -0,0 +1,177 @@
+#include "mandel/parallel.hpp"
+#include "mandel/trace.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace mandel {
+
+std::vector<Tile> make_tiles(int width, int height, int tile_w, int tile_h) {
+  std::vector<Tile> tiles;
+  if (width <= 0 || height <= 0)
+    return tiles;
+  tile_w = std::max(tile_w, 1);
+  tile_h = std::max(tile_h, 1);
+  for (int y0 = 0; y0 < height; y0 += tile_h) {
+    const int y1 = std::min(y0 + tile_h, height);
+    for (int x0 = 0; x0 < width; x0 += tile_w)
+      tiles.push_back(Tile{x0, y0, std::min(x0 + tile_w, width), y1});
+  }
+  return tiles;
+}
+
+int resolve_threads(int requested) {
+  if (requested > 0)
+    return requested;
+  const unsigned hw = std::thread::hardware_concurrency();
+  return hw == 0 ? 1 : static_cast<int>(hw);
+}
+
+ThreadPool::ThreadPool(int threads, Tracer *tracer) : tracer_(tracer) {
+  const int n = std::max(threads, 1);
+  for (int i = 0; i < n; ++i)
+    queues_.push_back(std::make_unique<Queue>());
+  for (int i = 1; i < n; ++i)
+    workers_.emplace_back([this, i] { worker_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto &t : workers_)
+    t.join();
+}
+
+void ThreadPool::submit(TaskGroup &group, std::size_t count,
+                        const IndexFn &fn, Deal deal) {
+  if (count == 0)
+    return;
+  group.pending_ += count;
+  const std::size_t parts = queues_.size();
+  const bool pinned = deal == Deal::pinned;
+  // Under mu_, so that a worker cannot miss the wake-up between checking
+  // the counts and blocking.
+  std::lock_guard<std::mutex> wake(mu_);
+  if (deal == Deal::interleaved) {
+    for (std::size_t q = 0; q < parts && q < count; ++q) {
+      std::lock_guard<std::mutex> lk(queues_[q]->mu);
+      for (std::size_t i = q; i < count; i += parts)
+        queues_[q]->tasks.push_back(Task{&fn, i, &group, false});
+    }
+  } else {
+    const std::size_t chunk = (count + parts - 1) / parts;
+    for (std::size_t q = 0; q < parts; ++q) {
+      const std::size_t begin = q * chunk;
+      const std::size_t end = std::min(begin + chunk, count);
+      if (begin >= end)
+        break;
+      std::lock_guard<std::mutex> lk(queues_[q]->mu);
+      for (std::size_t i = begin; i < end; ++i)
+        queues_[q]->tasks.push_back(Task{&fn, i, &group, pinned});
+      if (pinned)
+        queues_[q]->pinned += static_cast<long>(end - begin);
+    }
+  }
+  if (!pinned)
+    queued_ += static_cast<long>(count);
+  work_cv_.notify_all();
+}
+
+bool ThreadPool::try_take(int self, Task &out) {
+  const int n = size();
+  {
+    Queue &own = *queues_[static_cast<std::size_t>(self)];
+    std::lock_guard<std::mutex> lk(own.mu);
+    if (!own.tasks.empty()) {
+      out = own.tasks.front();
+      own.tasks.pop_front();
+      if (out.pinned)
+        --own.pinned;
+      else
+        --queued_;
+      return true;
+    }
+  }
+  for (int k = 1; k < n; ++k) {
+    Queue &victim = *queues_[static_cast<std::size_t>((self + k) % n)];
+    std::lock_guard<std::mutex> lk(victim.mu);
+    if (victim.pinned == static_cast<long>(victim.tasks.size()))
+      continue;
+    const auto it = std::find_if(victim.tasks.rbegin(), victim.tasks.rend(),
+                                 [](const Task &t) { return !t.pinned; });
+    out = *it;
+    victim.tasks.erase(std::next(it).base());
+    --queued_;
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::run(const Task &t, int self) {
+  try {
+    (*t.fn)(t.index, self);
+  } catch (...) {
+    std::lock_guard<std::mutex> lk(t.group->error_mu_);
+    if (!t.group->error_)
+      t.group->error_ = std::current_exception();
+  }
+  if (--t.group->pending_ == 0) {
+    { std::lock_guard<std::mutex> lk(mu_); }
+    done_cv_.notify_all();
+  }
+}
+
+void ThreadPool::worker_loop(int self) {
+  for (;;) {
+    Task t{};
+    if (try_take(self, t)) {
+      run(t, self);
+      continue;
+    }
+    std::unique_lock<std::mutex> lk(mu_);
+    const std::uint64_t t0 = tracer_ ? tracer_->now() : 0;
+    const Queue &own = *queues_[static_cast<std::size_t>(self)];
+    work_cv_.wait(lk, [&] {
+      return stop_ || queued_.load() > 0 || own.pinned.load() > 0;
+    });
+    if (stop_)
+      return;
+    lk.unlock();
+    if (tracer_)
+      tracer_->record(self, TraceKind::wait, t0, tracer_->now());
+  }
+}
+
+void ThreadPool::wait(TaskGroup &group) {
+  while (!group.done()) {
+    Task t{};
+    if (try_take(0, t)) {
+      run(t, 0);
+      continue;
+    }
+    // Nothing left to help with: the remaining tasks are running elsewhere.
+    std::unique_lock<std::mutex> lk(mu_);
+    const std::uint64_t t0 = tracer_ ? tracer_->now() : 0;
+    done_cv_.wait(lk, [&] { return group.done(); });
+    lk.unlock();
+    if (tracer_)
+      tracer_->record(0, TraceKind::wait, t0, tracer_->now());
+  }
+  std::lock_guard<std::mutex> lk(group.error_mu_);
+  if (group.error_) {
+    auto e = group.error_;
+    group.error_ = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+void ThreadPool::parallel_for(std::size_t count, const IndexFn &fn,
+                              Deal deal) {
+  TaskGroup group;
+  submit(group, count, fn, deal);
+  wait(group);
+}
+
+} // namespace mandel
@@ -0,0 +1,115 @@
+#include "mandel/perf.hpp"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mandel {
+
+const char *perf_event_name(PerfEvent e) {
+  switch (e) {
+  case PerfEvent::cycles:
+    return "cycles";
+  case PerfEvent::instructions:
+    return "instructions";
+  case PerfEvent::branch_misses:
+    return "branch_misses";
+  case PerfEvent::cache_misses:
+    return "cache_misses";
+  }
+  return "?";
+}
+
+bool PerfCounters::available() const {
+  for (int fd : fd_)
+    if (fd >= 0)
+      return true;
+  return false;
+}
+
+#if defined(__linux__)
+
+namespace {
+
+constexpr std::uint64_t kConfig[kPerfEvents] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+
+std::string open_error(int err) {
+  std::string why = std::string("perf_event_open: ") + std::strerror(err);
+  if (err == EACCES || err == EPERM) {
+    std::ifstream f("/proc/sys/kernel/perf_event_paranoid");
+    int level = 0;
+    if (f >> level)
+      why += " (perf_event_paranoid is " + std::to_string(level) + ")";
+  } else if (err == ENOENT || err == EOPNOTSUPP) {
+    why += " (no hardware counters, e.g. in a virtual machine)";
+  }
+  return why;
+}
+
+} // namespace
+
+PerfCounters::PerfCounters(Scope scope) {
+  fd_.fill(-1);
+  for (std::size_t i = 0; i < kPerfEvents; ++i) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = kConfig[i];
+    // User space only, which perf_event_paranoid <= 2 allows anyone.
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Threads created later add to the count (read() sums them).
+    attr.inherit = scope == Scope::process ? 1 : 0;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    const long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd >= 0) {
+      fd_[i] = static_cast<int>(fd);
+    } else if (reason_.empty()) {
+      reason_ = open_error(errno);
+    }
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : fd_)
+    if (fd >= 0)
+      close(fd);
+}
+
+PerfSample PerfCounters::read() const {
+  PerfSample s;
+  for (std::size_t i = 0; i < kPerfEvents; ++i) {
+    std::uint64_t v[3]; // value, time enabled, time running
+    if (fd_[i] < 0 || ::read(fd_[i], v, sizeof v) != sizeof v)
+      continue;
+    if (v[2] > 0 && v[2] < v[1])
+      v[0] = static_cast<std::uint64_t>(static_cast<double>(v[0]) *
+                                        static_cast<double>(v[1]) /
+                                        static_cast<double>(v[2]));
+    s.count[i] = v[0];
+  }
+  return s;
+}
+
+#else
+
+PerfCounters::PerfCounters(Scope) : reason_("perf_event_open is Linux-only") {
+  fd_.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+PerfSample PerfCounters::read() const { return {}; }
+
+#endif
+
+} // namespace mandel
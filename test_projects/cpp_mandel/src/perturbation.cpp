@@ -0,0 +1,156 @@
+#include "mandel/perturbation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mandel {
+
+ReferenceOrbit reference_orbit(DoubleDouble cx, DoubleDouble cy,
+                               int max_iters) {
+  ReferenceOrbit ref;
+  ref.re.reserve(static_cast<std::size_t>(max_iters) + 1);
+  ref.im.reserve(static_cast<std::size_t>(max_iters) + 1);
+  DoubleDouble zr, zi;
+  const DoubleDouble two{2.0, 0.0};
+  for (int it = 0;; ++it) {
+    ref.re.push_back(zr.hi);
+    ref.im.push_back(zi.hi);
+    if (it == max_iters || zr.hi * zr.hi + zi.hi * zi.hi > 4.0)
+      break;
+    const DoubleDouble zr2 = zr * zr - zi * zi + cx;
+    zi = two * zr * zi + cy;
+    zr = zr2;
+  }
+  return ref;
+}
+
+std::pair<DoubleDouble, DoubleDouble> view_center(const Params &p) {
+  const DoubleDouble cx = p.center_x_text.empty()
+                              ? DoubleDouble{p.center_x, 0.0}
+                              : parse_double_double(p.center_x_text);
+  const DoubleDouble cy = p.center_y_text.empty()
+                              ? DoubleDouble{p.center_y, 0.0}
+                              : parse_double_double(p.center_y_text);
+  return {cx, cy};
+}
+
+std::pair<double, double> perturbed_last_state(const ReferenceOrbit &ref,
+                                               double dcx, double dcy,
+                                               int max_iters, int start,
+                                               double dzr_start,
+                                               double dzi_start, int *iters) {
+  const double *Zr = ref.re.data();
+  const double *Zi = ref.im.data();
+  const std::size_t last = ref.size() - 1;
+  double dzr = dzr_start, dzi = dzi_start;
+  auto n = static_cast<std::size_t>(start);
+  double zr = Zr[n] + dzr, zi = Zi[n] + dzi;
+  int it = start;
+  while (it < max_iters && (zr * zr + zi * zi) <= 4.0) {
+    const double dzr2 = 2.0 * (Zr[n] * dzr - Zi[n] * dzi) +
+                        (dzr * dzr - dzi * dzi) + dcx;
+    const double dzi2 = 2.0 * (Zr[n] * dzi + Zi[n] * dzr) +
+                        2.0 * dzr * dzi + dcy;
+    dzr = dzr2;
+    dzi = dzi2;
+    ++n;
+    ++it;
+    zr = Zr[n] + dzr;
+    zi = Zi[n] + dzi;
+    if (zr * zr + zi * zi < dzr * dzr + dzi * dzi || n == last) {
+      dzr = zr;
+      dzi = zi;
+      n = 0;
+    }
+  }
+  if (iters)
+    *iters = it;
+  return {zr, zi};
+}
+
+SeriesApproximation::SeriesApproximation(const ReferenceOrbit &ref,
+                                         int order, double tol, double radius,
+                                         double min_radius)
+    : order_(order), radius_(radius) {
+  const auto terms = static_cast<std::size_t>(order) + 1;
+  const double t_min = min_radius / radius;
+  // Current coefficients a[k - 1] = A_{n,k} * radius^k, k = 1..order+1.
+  std::vector<double> ar(terms, 0.0), ai(terms, 0.0), br(terms), bi(terms);
+  re_.assign(terms, 0.0);
+  im_.assign(terms, 0.0);
+  limit_.push_back(std::numeric_limits<double>::infinity());
+  // Bound on |dz_n| for |dc| <= t * radius.
+  auto bound = [&](double t) {
+    double d = 0.0;
+    for (std::size_t k = order_; k-- > 0;)
+      d = (d + std::hypot(ar[k], ai[k])) * t;
+    return d;
+  };
+  for (std::size_t n = 0; n + 2 < ref.size(); ++n) {
+    const double zr2 = 2.0 * ref.re[n], zi2 = 2.0 * ref.im[n];
+    for (std::size_t k = 0; k < terms; ++k) {
+      double sr = zr2 * ar[k] - zi2 * ai[k];
+      double si = zr2 * ai[k] + zi2 * ar[k];
+      // Powers i + j = k + 2 (1-based), i.e. indices i + j = k - 1.
+      for (std::size_t i = 0, j = k - 1; i < k; ++i, --j) {
+        sr += ar[i] * ar[j] - ai[i] * ai[j];
+        si += ar[i] * ai[j] + ai[i] * ar[j];
+      }
+      br[k] = sr;
+      bi[k] = si;
+    }
+    br[0] += radius;
+    ar.swap(br);
+    ai.swap(bi);
+
+    // Largest t that may skip step n + 1; no pixel is beyond the radius.
+    double t = std::min(limit_.back(), 1.0);
+    const double first = std::hypot(ar[0], ai[0]);
+    const double dropped = std::hypot(ar[order_], ai[order_]);
+    if (dropped > 0.0)
+      t = std::min(t, std::pow(tol * first / dropped, 1.0 / order_));
+    const double z = std::hypot(ref.re[n + 1], ref.im[n + 1]);
+    const double room = std::min(0.5 * z, 2.0 - z);
+    if (room <= 0.0) {
+      t = 0.0;
+    } else if (bound(t) > room) {
+      double lo = 0.0;
+      for (int i = 0; i < 64; ++i) {
+        const double mid = 0.5 * (lo + t);
+        (bound(mid) <= room ? lo : t) = mid;
+      }
+      t = lo;
+    }
+    if (t < t_min)
+      break;
+    limit_.push_back(t);
+    re_.insert(re_.end(), ar.begin(), ar.end());
+    im_.insert(im_.end(), ai.begin(), ai.end());
+  }
+}
+
+int SeriesApproximation::skip(double r) const {
+  const double t = r / radius_;
+  const auto it = std::partition_point(limit_.begin(), limit_.end(),
+                                       [t](double l) { return l >= t; });
+  return static_cast<int>(it - limit_.begin()) - 1;
+}
+
+std::pair<double, double> SeriesApproximation::delta(int n, double dcx,
+                                                     double dcy) const {
+  const std::size_t terms = static_cast<std::size_t>(order_) + 1;
+  const double *cr = re_.data() + static_cast<std::size_t>(n) * terms;
+  const double *ci = im_.data() + static_cast<std::size_t>(n) * terms;
+  const double ur = dcx / radius_, ui = dcy / radius_;
+  // Horner over k = order..1, then one more factor of u.
+  double sr = 0.0, si = 0.0;
+  for (std::size_t k = static_cast<std::size_t>(order_); k-- > 0;) {
+    const double tr = sr * ur - si * ui + cr[k];
+    si = sr * ui + si * ur + ci[k];
+    sr = tr;
+  }
+  return {sr * ur - si * ui, sr * ui + si * ur};
+}
+
+} // namespace mandel
@@ -0,0 +1,85 @@
+#include "mandel/stats.hpp"
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+// windows.h first: psapi.h needs its types.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+namespace mandel {
+
+#if defined(_WIN32)
+
+namespace {
+
+// FILETIME counts 100 ns units.
+double seconds(const FILETIME &t) {
+  const ULONGLONG n =
+      (static_cast<ULONGLONG>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+  return static_cast<double>(n) * 1e-7;
+}
+
+} // namespace
+
+double process_cpu_seconds() {
+  FILETIME created, exited, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel,
+                       &user))
+    return 0.0;
+  return seconds(kernel) + seconds(user);
+}
+
+double thread_cpu_seconds() {
+  FILETIME created, exited, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user))
+    return 0.0;
+  return seconds(kernel) + seconds(user);
+}
+
+std::uint64_t peak_rss_bytes() {
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof pmc))
+    return 0;
+  return pmc.PeakWorkingSetSize;
+}
+
+#else
+
+double process_cpu_seconds() {
+  rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) != 0)
+    return 0.0;
+  auto seconds = [](const timeval &t) {
+    return static_cast<double>(t.tv_sec) +
+           static_cast<double>(t.tv_usec) * 1e-6;
+  };
+  return seconds(ru.ru_utime) + seconds(ru.ru_stime);
+}
+
+double thread_cpu_seconds() {
+  timespec t;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0)
+    return 0.0;
+  return static_cast<double>(t.tv_sec) + static_cast<double>(t.tv_nsec) * 1e-9;
+}
+
+std::uint64_t peak_rss_bytes() {
+  rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) != 0)
+    return 0;
+  // ru_maxrss is in bytes on macOS and in kilobytes elsewhere.
+#if defined(__APPLE__)
+  return static_cast<std::uint64_t>(ru.ru_maxrss);
+#else
+  return static_cast<std::uint64_t>(ru.ru_maxrss) * 1024;
+#endif
+}
+
+#endif
+
+} // namespace mandel
@@ -0,0 +1,137 @@
+#include "mandel/trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <stdexcept>
+
+namespace mandel {
+
+namespace {
+
+struct KindInfo {
+  const char *name;
+  const char *cat;
+  int nargs;
+  const char *arg[4];
+};
+
+KindInfo kind_info(TraceKind k) {
+  switch (k) {
+  case TraceKind::tile:
+    return {"tile", "compute", 4, {"x0", "y0", "x1", "y1"}};
+  case TraceKind::flush:
+    return {"flush", "io", 3, {"frame", "y0", "rows", nullptr}};
+  case TraceKind::finish:
+    return {"finish", "io", 1, {"frame", nullptr, nullptr, nullptr}};
+  case TraceKind::wait:
+    return {"wait", "queue", 0, {}};
+  }
+  return {"?", "?", 0, {}};
+}
+
+std::atomic<std::uint64_t> next_tracer_id{1};
+
+// Chrome expects microseconds.
+void put_us(std::FILE *f, const char *key, std::uint64_t ns) {
+  std::fprintf(f, ", \"%s\": %" PRIu64 ".%03u", key, ns / 1000,
+               static_cast<unsigned>(ns % 1000));
+}
+
+} // namespace
+
+Tracer::Tracer()
+    : id_(next_tracer_id++), start_(std::chrono::steady_clock::now()) {}
+
+Tracer::Buffer &Tracer::buffer(int worker) {
+  thread_local std::uint64_t cached_id = 0;
+  thread_local Buffer *cached = nullptr;
+  if (cached_id != id_) {
+    std::lock_guard<std::mutex> lk(mu_);
+    buffers_.push_back(std::make_unique<Buffer>(Buffer{worker, {}}));
+    buffers_.back()->events.reserve(4096);
+    cached = buffers_.back().get();
+    cached_id = id_;
+  }
+  return *cached;
+}
+
+void Tracer::record(int worker, TraceKind kind, std::uint64_t begin,
+                    std::uint64_t end, std::array<int, 4> args) {
+  buffer(worker).events.push_back(TraceEvent{kind, begin, end, args});
+}
+
+std::uint64_t Tracer::total(TraceKind kind, int worker) const {
+  std::uint64_t ns = 0;
+  for (const auto &b : buffers_)
+    if (b->worker == worker)
+      for (const TraceEvent &e : b->events)
+        if (e.kind == kind)
+          ns += e.end - e.begin;
+  return ns;
+}
+
+void Tracer::write(const std::string &path) const {
+  // Thread ids in participant order, main thread first.
+  std::vector<const Buffer *> threads;
+  for (const auto &b : buffers_)
+    threads.push_back(b.get());
+  std::stable_sort(threads.begin(), threads.end(),
+                   [](const Buffer *a, const Buffer *b) {
+                     return a->worker < b->worker;
+                   });
+  struct Ref {
+    const TraceEvent *e;
+    int tid;
+  };
+  std::vector<Ref> all;
+  for (std::size_t t = 0; t < threads.size(); ++t)
+    for (const TraceEvent &e : threads[t]->events)
+      all.push_back(Ref{&e, static_cast<int>(t) + 1});
+  std::stable_sort(all.begin(), all.end(), [](const Ref &a, const Ref &b) {
+    return a.e->begin < b.e->begin;
+  });
+
+  std::FILE *f = std::fopen(path.c_str(), "wb");
+  if (!f)
+    throw std::runtime_error("Failed to open trace for writing: " + path);
+  std::fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", f);
+  std::fputs("{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, "
+             "\"tid\": 0, \"args\": {\"name\": \"mandel\"}}",
+             f);
+  for (std::size_t t = 0; t < threads.size(); ++t) {
+    char name[32];
+    if (threads[t]->worker == 0)
+      std::snprintf(name, sizeof name, "main");
+    else
+      std::snprintf(name, sizeof name, "worker %d", threads[t]->worker);
+    std::fprintf(f,
+                 ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                 "\"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                 static_cast<int>(t) + 1, name);
+  }
+  // Complete ("X") events: a begin and an end in one record.
+  for (const Ref &r : all) {
+    const KindInfo k = kind_info(r.e->kind);
+    std::fprintf(f,
+                 ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+                 "\"pid\": 1, \"tid\": %d",
+                 k.name, k.cat, r.tid);
+    put_us(f, "ts", r.e->begin);
+    put_us(f, "dur", r.e->end - r.e->begin);
+    if (k.nargs > 0) {
+      std::fputs(", \"args\": {", f);
+      for (int i = 0; i < k.nargs; ++i)
+        std::fprintf(f, "%s\"%s\": %d", i ? ", " : "", k.arg[i],
+                     r.e->args[static_cast<std::size_t>(i)]);
+      std::fputs("}", f);
+    }
+    std::fputs("}", f);
+  }
+  std::fputs("\n]}\n", f);
+  const bool failed = std::ferror(f) != 0;
+  if (std::fclose(f) != 0 || failed)
+    throw std::runtime_error("I/O error while writing trace: " + path);
+}
+
+} // namespace mandel
@@ -0,0 +1,74 @@
+# cmake-format: off
+# ------------------------------------------------------------------------------
+# tests/batch.cmake
+#
+# CTest driver for mandel_cli --batch. Writes a small variants file with two
+# good lines around a bad one, runs it once, and checks that:
+#   1) the run exits non-zero and names the bad line on stderr
+#   2) both good variants were still written
+#   3) each batch output is byte-identical to a standalone run with the same
+#      options
+#
+# Variables (passed by add_test(... COMMAND cmake -D... -P batch.cmake)):
+#   CLI    : full path to the mandel_cli executable              (REQUIRED)
+#   DIR    : scratch directory for the variants and outputs      (REQUIRED)
+#
+# Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
+# ------------------------------------------------------------------------------
+# cmake-format: on
+
+foreach(var IN ITEMS CLI DIR)
+  if(NOT DEFINED ${var} OR "${${var}}" STREQUAL "")
+    message(FATAL_ERROR "batch.cmake: ${var} not provided.")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE "${DIR}")
+file(MAKE_DIRECTORY "${DIR}")
+file(
+  WRITE "${DIR}/variants.jsonl"
+  "{\"out\": \"${DIR}/a.csv\", \"width\": 33, \"height\": 21}\n"
+  "{\"out\": \"${DIR}/bad.csv\", \"max_iters\": 0}\n"
+  "{\"out\": \"${DIR}/b.npy\", \"format\": \"npy\", \"center_y\": 0.3}\n")
+
+# ---- batch run: must report line 2 and still write lines 1 and 3 -------------
+execute_process(
+  COMMAND "${CLI}" --width 17 --height 9 --max-iters 50 --batch
+          "${DIR}/variants.jsonl"
+  RESULT_VARIABLE run_rv
+  OUTPUT_VARIABLE run_out
+  ERROR_VARIABLE run_err)
+if(run_rv EQUAL 0)
+  message(FATAL_ERROR "batch with a bad variant exited 0\n${run_err}")
+endif()
+if(NOT run_err MATCHES "variants.jsonl:2:")
+  message(FATAL_ERROR "bad variant not reported by line:\n${run_err}")
+endif()
+
+# ---- standalone runs of the good variants -------------------------------------
+set(ref_a --width 33 --height 21 --max-iters 50)
+set(ref_b --width 17 --height 9 --max-iters 50 --format npy --center-y 0.3)
+foreach(side IN ITEMS a b)
+  if(side STREQUAL "a")
+    set(out "${DIR}/a.csv")
+  else()
+    set(out "${DIR}/b.npy")
+  endif()
+  execute_process(
+    COMMAND "${CLI}" ${ref_${side}} --out "${out}.ref"
+    RESULT_VARIABLE ref_rv
+    ERROR_VARIABLE ref_err)
+  if(NOT ref_rv EQUAL 0)
+    message(FATAL_ERROR "standalone run failed (${ref_rv}):\n${ref_err}")
+  endif()
+  if(NOT EXISTS "${out}")
+    message(FATAL_ERROR "batch did not write ${out}")
+  endif()
+  file(SHA256 "${out}" hash_batch)
+  file(SHA256 "${out}.ref" hash_ref)
+  if(NOT hash_batch STREQUAL hash_ref)
+    message(FATAL_ERROR "batch output differs from standalone run: ${out}")
+  endif()
+endforeach()
+
+message(STATUS "Batch OK: ${DIR}")
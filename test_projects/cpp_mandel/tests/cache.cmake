@@ -0,0 +1,107 @@
+# cmake-format: off
+# ------------------------------------------------------------------------------
+# tests/cache.cmake
+#
+# CTest driver for mandel_cli --cache-dir. Checks that:
+#   1) the first run stores one entry and writes the same bytes as a run
+#      without a cache
+#   2) a repeat run (with a different thread count, which does not change
+#      the output) is served from that entry rather than recomputed
+#   3) raw output comes back together with its sidecar
+#   4) beyond --cache-max-mb only the most recently used entry survives
+#
+# Variables (passed by add_test(... COMMAND cmake -D... -P cache.cmake)):
+#   CLI    : full path to the mandel_cli executable              (REQUIRED)
+#   DIR    : scratch directory for the cache and outputs         (REQUIRED)
+#
+# Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
+# ------------------------------------------------------------------------------
+# cmake-format: on
+
+foreach(var IN ITEMS CLI DIR)
+  if(NOT DEFINED ${var} OR "${${var}}" STREQUAL "")
+    message(FATAL_ERROR "cache.cmake: ${var} not provided.")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE "${DIR}")
+file(MAKE_DIRECTORY "${DIR}")
+set(STORE "${DIR}/cache")
+
+function(run)
+  execute_process(
+    COMMAND "${CLI}" ${ARGN}
+    RESULT_VARIABLE rv
+    ERROR_VARIABLE err)
+  if(NOT rv EQUAL 0)
+    message(FATAL_ERROR "mandel_cli ${ARGN} failed (${rv}):\n${err}")
+  endif()
+endfunction()
+
+function(expect_same a b)
+  file(SHA256 "${a}" ha)
+  file(SHA256 "${b}" hb)
+  if(NOT ha STREQUAL hb)
+    message(FATAL_ERROR "${a} and ${b} differ")
+  endif()
+endfunction()
+
+function(entries dir out_var)
+  file(
+    GLOB found
+    LIST_DIRECTORIES true
+    "${dir}/*")
+  list(FILTER found EXCLUDE REGEX "/tmp-[^/]*$")
+  set(${out_var}
+      "${found}"
+      PARENT_SCOPE)
+endfunction()
+
+set(view --width 33 --height 21 --max-iters 50)
+
+# ---- 1) first run stores an entry --------------------------------------------
+run(${view} --out "${DIR}/ref.csv")
+run(${view} --cache-dir "${STORE}" --out "${DIR}/a.csv")
+expect_same("${DIR}/ref.csv" "${DIR}/a.csv")
+entries("${STORE}" found)
+list(LENGTH found n)
+if(NOT n EQUAL 1)
+  message(FATAL_ERROR "expected 1 cache entry, found ${n}: ${found}")
+endif()
+
+# ---- 2) a repeat run is a hit: it returns whatever the entry holds -----------
+run(${view} --threads 2 --cache-dir "${STORE}" --out "${DIR}/b.csv")
+expect_same("${DIR}/ref.csv" "${DIR}/b.csv")
+file(WRITE "${found}/data" "from cache\n")
+run(${view} --cache-dir "${STORE}" --out "${DIR}/c.csv")
+file(READ "${DIR}/c.csv" c)
+if(NOT c STREQUAL "from cache\n")
+  message(FATAL_ERROR "repeat run did not use the cache entry")
+endif()
+file(REMOVE_RECURSE "${STORE}")
+
+# ---- 3) raw output and its sidecar -------------------------------------------
+run(${view} --format raw --out "${DIR}/ref.raw")
+run(${view} --format raw --cache-dir "${STORE}" --out "${DIR}/r.raw")
+file(REMOVE "${DIR}/r.raw" "${DIR}/r.raw.json")
+run(${view} --format raw --cache-dir "${STORE}" --out "${DIR}/r.raw")
+expect_same("${DIR}/ref.raw" "${DIR}/r.raw")
+expect_same("${DIR}/ref.raw.json" "${DIR}/r.raw.json")
+file(REMOVE_RECURSE "${STORE}")
+
+# ---- 4) LRU cap: about 1 kB holds one small CSV entry but not two ------------
+set(small --width 4 --max-iters 50 --cache-dir "${STORE}" --cache-max-mb
+          0.001)
+run(${small} --height 4 --out "${DIR}/s4.csv")
+run(${small} --height 3 --out "${DIR}/s3.csv")
+entries("${STORE}" found)
+list(LENGTH found n)
+if(NOT n EQUAL 1)
+  message(FATAL_ERROR "expected 1 cache entry after eviction, found ${n}")
+endif()
+file(READ "${found}/key" key)
+if(NOT key MATCHES "height=3\n")
+  message(FATAL_ERROR "eviction kept the older entry:\n${key}")
+endif()
+
+message(STATUS "Cache OK: ${DIR}")
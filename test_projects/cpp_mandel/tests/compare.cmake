@@ -0,0 +1,57 @@
+# cmake-format: off
+# ------------------------------------------------------------------------------
+# tests/compare.cmake
+#
+# CTest driver that runs mandel_cli twice with different flags and checks that
+# both runs produce byte-identical output files. Used to pin down that
+# performance options (threads, kernels, ...) never change the results.
+#
+# Variables (passed by add_test(... COMMAND cmake -D... -P compare.cmake)):
+#   CLI    : full path to the mandel_cli executable              (REQUIRED)
+#   OUT_A  : output path for the reference run                   (REQUIRED)
+#   OUT_B  : output path for the candidate run                   (REQUIRED)
+#   ARGS   : flags shared by both runs (;-list)                  (OPTIONAL)
+#   ARGS_A : extra flags for the reference run (;-list)          (OPTIONAL)
+#   ARGS_B : extra flags for the candidate run (;-list)          (OPTIONAL)
+#
+# Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
+# ------------------------------------------------------------------------------
+# cmake-format: on
+
+foreach(var IN ITEMS CLI OUT_A OUT_B)
+  if(NOT DEFINED ${var} OR "${${var}}" STREQUAL "")
+    message(FATAL_ERROR "compare.cmake: ${var} not provided.")
+  endif()
+endforeach()
+
+# ---- run both configurations -------------------------------------------------
+foreach(side IN ITEMS A B)
+  set(launch_cmd "${CLI}" ${ARGS} ${ARGS_${side}} --out "${OUT_${side}}")
+  execute_process(
+    COMMAND ${launch_cmd}
+    RESULT_VARIABLE run_rv
+    OUTPUT_VARIABLE run_out
+    ERROR_VARIABLE run_err)
+  if(NOT run_rv EQUAL 0)
+    message(
+      FATAL_ERROR
+        "mandel_cli exited with non-zero status (${run_rv})\n"
+        "Command : ${launch_cmd}\n" "STDOUT  :\n${run_out}\n"
+        "STDERR  :\n${run_err}\n")
+  endif()
+  if(NOT EXISTS "${OUT_${side}}")
+    message(FATAL_ERROR "Output not produced at expected path: ${OUT_${side}}")
+  endif()
+endforeach()
+
+# ---- outputs must match byte for byte ----------------------------------------
+file(SHA256 "${OUT_A}" hash_a)
+file(SHA256 "${OUT_B}" hash_b)
+if(NOT hash_a STREQUAL hash_b)
+  message(
+    FATAL_ERROR
+      "Outputs differ.\n" "Reference : ${OUT_A} (${ARGS_A})\n"
+      "Candidate : ${OUT_B} (${ARGS_B})\n")
+endif()
+
+message(STATUS "Compare OK: ${ARGS_A} == ${ARGS_B}")
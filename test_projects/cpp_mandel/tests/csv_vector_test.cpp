@@ -0,0 +1,48 @@
+// Checks the std::vector<PixelResult> API end to end: compute_grid(p, vec)
+// followed by write_csv(path, vec) writes the same file as the GridResult
+// overloads.
+#include "mandel/core.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string slurp(const std::string &path) {
+  std::ifstream f(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+
+} // namespace
+
+int main() {
+  mandel::Params p;
+  p.width = 67;
+  p.height = 23;
+  p.max_iters = 150;
+  p.threads = 2;
+
+  std::vector<mandel::PixelResult> vec;
+  mandel::compute_grid(p, vec);
+  mandel::write_csv("csv_vector_test.vec.csv", vec);
+
+  mandel::GridResult grid;
+  mandel::compute_grid(p, grid);
+  mandel::write_csv("csv_vector_test.grid.csv", grid);
+
+  const std::string a = slurp("csv_vector_test.vec.csv");
+  const std::string b = slurp("csv_vector_test.grid.csv");
+  std::remove("csv_vector_test.vec.csv");
+  std::remove("csv_vector_test.grid.csv");
+  if (a.empty() || a != b) {
+    std::fprintf(stderr, "vector CSV differs from GridResult CSV (%zu vs %zu "
+                         "bytes)\n",
+                 a.size(), b.size());
+    return 1;
+  }
+  std::printf("ok\n");
+  return 0;
+}
@@ -0,0 +1,93 @@
+# cmake-format: off
+# ------------------------------------------------------------------------------
+# tests/frames.cmake
+#
+# CTest driver for mandel_cli --frames. Checks that:
+#   1) each frame of a zoom sequence (raw, with extra channels and mirrored
+#      rows) is byte-identical to a separate run at that frame's scale,
+#      sidecar included
+#   2) --out patterns without exactly one frame number are rejected
+#   3) with --cache-dir, a repeated sequence is served from the cache
+#
+# Variables (passed by add_test(... COMMAND cmake -D... -P frames.cmake)):
+#   CLI    : full path to the mandel_cli executable              (REQUIRED)
+#   DIR    : scratch directory for the outputs                   (REQUIRED)
+#
+# Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
+# ------------------------------------------------------------------------------
+# cmake-format: on
+
+foreach(var IN ITEMS CLI DIR)
+  if(NOT DEFINED ${var} OR "${${var}}" STREQUAL "")
+    message(FATAL_ERROR "frames.cmake: ${var} not provided.")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE "${DIR}")
+file(MAKE_DIRECTORY "${DIR}")
+
+function(run)
+  execute_process(
+    COMMAND "${CLI}" ${ARGN}
+    RESULT_VARIABLE rv
+    ERROR_VARIABLE err)
+  if(NOT rv EQUAL 0)
+    message(FATAL_ERROR "mandel_cli ${ARGN} failed (${rv}):\n${err}")
+  endif()
+endfunction()
+
+function(expect_same a b)
+  file(SHA256 "${a}" ha)
+  file(SHA256 "${b}" hb)
+  if(NOT ha STREQUAL hb)
+    message(FATAL_ERROR "${a} and ${b} differ")
+  endif()
+endfunction()
+
+# ---- 1) frames match single runs ---------------------------------------------
+# Halving keeps every scale exact, so the decimal texts below are the
+# doubles the sequence computes.
+set(view --width 77 --height 45 --center-y 0 --max-iters 300 --format raw
+         --channels it,x,y,smooth)
+run(${view} --scale 0.01 --frames 3 --zoom-factor 2 --threads 3
+    --out "${DIR}/zoom_%02d.raw")
+set(k 0)
+foreach(scale IN ITEMS 0.01 0.005 0.0025)
+  run(${view} --scale ${scale} --out "${DIR}/ref_${k}.raw")
+  expect_same("${DIR}/ref_${k}.raw" "${DIR}/zoom_0${k}.raw")
+  expect_same("${DIR}/ref_${k}.raw.json" "${DIR}/zoom_0${k}.raw.json")
+  math(EXPR k "${k} + 1")
+endforeach()
+
+# ---- 2) bad patterns ---------------------------------------------------------
+foreach(pattern IN ITEMS "plain.csv" "two_%d_%d.csv" "bad_%x.csv")
+  execute_process(
+    COMMAND "${CLI}" --frames 2 --out "${DIR}/${pattern}"
+    RESULT_VARIABLE rv
+    OUTPUT_QUIET ERROR_QUIET)
+  if(rv EQUAL 0)
+    message(FATAL_ERROR "--frames accepted --out ${pattern}")
+  endif()
+endforeach()
+
+# ---- 3) cached frames --------------------------------------------------------
+set(small --width 20 --height 10 --frames 2 --zoom-factor 1.5 --cache-dir
+          "${DIR}/cache")
+run(${small} --out "${DIR}/c_%d.csv")
+file(GLOB entries LIST_DIRECTORIES true "${DIR}/cache/*")
+list(LENGTH entries n)
+if(NOT n EQUAL 2)
+  message(FATAL_ERROR "expected 2 cache entries, found ${n}")
+endif()
+foreach(entry IN LISTS entries)
+  file(WRITE "${entry}/data" "from cache\n")
+endforeach()
+run(${small} --out "${DIR}/d_%d.csv")
+foreach(k 0 1)
+  file(READ "${DIR}/d_${k}.csv" d)
+  if(NOT d STREQUAL "from cache\n")
+    message(FATAL_ERROR "frame ${k} was not served from the cache")
+  endif()
+endforeach()
+
+message(STATUS "Frames OK: ${DIR}")
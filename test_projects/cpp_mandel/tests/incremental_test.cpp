@@ -0,0 +1,96 @@
+// Checks that compute_grid_incremental() matches compute_grid() bit for bit
+// (extra channels included) for pans by whole pixels, between odd and even
+// sizes and across engines, that it actually reuses pixels there, and that
+// it falls back to a full compute for fractional offsets and settings that
+// change the per-pixel result.
+#include "mandel/core.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+bool same(const mandel::GridResult &a, const mandel::GridResult &b) {
+  if (a.width() != b.width() || a.height() != b.height())
+    return false;
+  const std::size_t n = a.size();
+  auto eq = [n](const auto *x, const auto *y) {
+    if (!x || !y)
+      return x == y;
+    return std::memcmp(x, y, n * sizeof *x) == 0;
+  };
+  return eq(a.x(), b.x()) && eq(a.y(), b.y()) &&
+         eq(a.iterations(), b.iterations()) && eq(a.escaped(), b.escaped()) &&
+         eq(a.smooth(), b.smooth());
+}
+
+// Pans from prev to p; want_reuse: whether pixels must be copied.
+int check(const char *name, const mandel::Params &prev_params,
+          const mandel::Params &p, bool want_reuse) {
+  mandel::GridResult prev, expected, got;
+  mandel::compute_grid(prev_params, prev);
+  mandel::compute_grid(p, expected);
+  const std::size_t reused =
+      mandel::compute_grid_incremental(prev_params, prev, p, got);
+  int failures = 0;
+  if (!same(got, expected)) {
+    std::fprintf(stderr, "%s: differs from compute_grid\n", name);
+    ++failures;
+  }
+  if ((reused > 0) != want_reuse) {
+    std::fprintf(stderr, "%s: reused %zu pixels\n", name, reused);
+    ++failures;
+  }
+  std::printf("%-12s reused %zu of %zu pixels\n", name, reused, got.size());
+  return failures;
+}
+
+mandel::Params pan(mandel::Params p, double dx, double dy) {
+  p.center_x += dx * p.scale;
+  p.center_y += dy * p.scale;
+  return p;
+}
+
+} // namespace
+
+int main() {
+  mandel::Params base;
+  base.width = 131; // odd, and partial tiles
+  base.height = 75;
+  base.max_iters = 300;
+  base.scale = 0.02;
+
+  int failures = 0;
+  failures += check("identity", base, base, true);
+  failures += check("pan", base, pan(base, 10, -7), true);
+  failures += check("pan-far", base, pan(base, -90, 40), true);
+  failures += check("disjoint", base, pan(base, 500, 0), false);
+  failures += check("fractional", base, pan(base, 3.5, 0), false);
+
+  // 130 columns center between pixels of the 131-column view.
+  mandel::Params even = pan(base, 0.5, 0);
+  even.width = 130;
+  failures += check("even-width", base, even, true);
+
+  mandel::Params channels = base;
+  channels.channels = {mandel::Channel::smooth, mandel::Channel::x,
+                       mandel::Channel::iterations, mandel::Channel::escaped};
+  failures += check("channels", channels, pan(channels, 5, 5), true);
+  failures += check("no-channels", base, pan(channels, 5, 5), false);
+
+  mandel::Params subdivide = pan(base, -12, 3);
+  subdivide.engine = mandel::Engine::subdivide;
+  failures += check("subdivide", base, subdivide, true);
+  subdivide.fill = mandel::Fill::approximate;
+  failures += check("approximate", base, subdivide, false);
+
+  mandel::Params iters = pan(base, 4, 0);
+  iters.max_iters = 301;
+  failures += check("max-iters", base, iters, false);
+
+  if (failures != 0) {
+    std::fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,191 @@
+// Checks that every batch kernel the running CPU supports returns the same
+// final z as the scalar reference mandelbrot_last_state(), bit for bit: the
+// escape kernels with and without exact cycle detection (cycle_tol = 0), and
+// the Interior::exact (no-bailout) kernels; and the float kernels against
+// last_state<float>(). The unrolled scalar kernels are checked the same way.
+// Escape kernels must also report the reference's iteration count.
+// Kernels the CPU cannot run are reported and skipped.
+#include "mandel/kernels.hpp"
+#include "mandel/precision.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct View {
+  const char *name;
+  mandel::Params p;
+};
+
+mandel::Params view(double cx, double cy, double scale, int max_iters) {
+  mandel::Params p;
+  p.width = 67; // odd sizes exercise partially filled lane groups
+  p.height = 45;
+  p.center_x = cx;
+  p.center_y = cy;
+  p.scale = scale;
+  p.max_iters = max_iters;
+  return p;
+}
+
+bool same_bits(double a, double b) {
+  return std::memcmp(&a, &b, sizeof a) == 0;
+}
+
+int check(const char *name, mandel::BatchKernelFn fn, const View &v,
+          double cycle_tol) {
+  const mandel::Params &p = v.p;
+  std::vector<double> cx, cy;
+  for (int py = 0; py < p.height; ++py) {
+    for (int px = 0; px < p.width; ++px) {
+      auto [x, y] = mandel::map_pixel_to_plane(p, px, py);
+      cx.push_back(x);
+      cy.push_back(y);
+    }
+  }
+  int failures = 0;
+  // Whole grid as one queue, plus short queues that leave lanes empty.
+  for (std::size_t n : {cx.size(), std::size_t{1}, std::size_t{3},
+                        std::size_t{7}, std::size_t{13}}) {
+    std::vector<double> zx(n), zy(n);
+    std::vector<std::uint32_t> its(n);
+    fn(mandel::PixelBatch{cx.data(), cy.data(), n, p.max_iters, zx.data(),
+                          zy.data(), cycle_tol, its.data()});
+    for (std::size_t i = 0; i < n; ++i) {
+      int rit = 0;
+      auto [rx, ry] = mandel::mandelbrot_last_state_periodic(
+          cx[i], cy[i], p.max_iters, -1.0, &rit);
+      if (!same_bits(zx[i], rx) || !same_bits(zy[i], ry) ||
+          its[i] != static_cast<std::uint32_t>(rit)) {
+        if (failures++ < 5)
+          std::fprintf(stderr,
+                       "%s/%s (cycle_tol %g): pixel %zu (n=%zu) got "
+                       "(%.17g, %.17g) after %u, expected (%.17g, %.17g) "
+                       "after %d\n",
+                       name, v.name, cycle_tol, i, n, zx[i], zy[i], its[i],
+                       rx, ry, rit);
+      }
+    }
+  }
+  return failures;
+}
+
+int check_interior(mandel::Kernel k, const View &v) {
+  const mandel::Params &p = v.p;
+  std::vector<double> cx, cy;
+  for (int py = 0; py < p.height; ++py) {
+    for (int px = 0; px < p.width; ++px) {
+      auto [x, y] = mandel::map_pixel_to_plane(p, px, py);
+      if (mandel::in_cardioid_or_bulb(x, y)) {
+        cx.push_back(x);
+        cy.push_back(y);
+      }
+    }
+  }
+  std::vector<double> zx(cx.size()), zy(cx.size());
+  mandel::interior_exact_fn(k)(mandel::PixelBatch{
+      cx.data(), cy.data(), cx.size(), p.max_iters, zx.data(), zy.data()});
+  int failures = 0;
+  for (std::size_t i = 0; i < cx.size(); ++i) {
+    auto [rx, ry] = mandel::mandelbrot_last_state(cx[i], cy[i], p.max_iters);
+    if (!same_bits(zx[i], rx) || !same_bits(zy[i], ry)) {
+      if (failures++ < 5)
+        std::fprintf(stderr, "%s/%s interior: c=(%.17g, %.17g) mismatch\n",
+                     mandel::kernel_name(k), v.name, cx[i], cy[i]);
+    }
+  }
+  return failures;
+}
+
+// Precision::f32 escape kernel against last_state<float>(), and the float
+// interior kernel on cardioid/bulb points.
+int check_f32(mandel::Kernel k, const View &v) {
+  const mandel::Params &p = v.p;
+  std::vector<float> cx, cy, icx, icy;
+  for (int py = 0; py < p.height; ++py) {
+    for (int px = 0; px < p.width; ++px) {
+      auto [x, y] = mandel::map_pixel_to_plane(p, px, py);
+      cx.push_back(static_cast<float>(x));
+      cy.push_back(static_cast<float>(y));
+      if (mandel::in_cardioid_or_bulb(x, y)) {
+        icx.push_back(cx.back());
+        icy.push_back(cy.back());
+      }
+    }
+  }
+  std::vector<float> zx(cx.size()), zy(cx.size());
+  std::vector<std::uint32_t> its(cx.size());
+  mandel::kernel_f32_fn(k)(mandel::PixelBatchF32{cx.data(), cy.data(),
+                                                 cx.size(), p.max_iters,
+                                                 zx.data(), zy.data(), -1.0,
+                                                 its.data()});
+  std::vector<float> izx(icx.size()), izy(icx.size());
+  mandel::interior_exact_kernel_f32(mandel::PixelBatchF32{
+      icx.data(), icy.data(), icx.size(), p.max_iters, izx.data(),
+      izy.data()});
+  int failures = 0;
+  auto expect = [&](float cr, float ci, float gx, float gy) {
+    auto [x, y] = mandel::last_state<float>(cr, ci, p.max_iters);
+    const float rx = static_cast<float>(x), ry = static_cast<float>(y);
+    if (std::memcmp(&gx, &rx, sizeof gx) != 0 ||
+        std::memcmp(&gy, &ry, sizeof gy) != 0) {
+      if (failures++ < 5)
+        std::fprintf(stderr, "%s/%s f32: c=(%.9g, %.9g) mismatch\n",
+                     mandel::kernel_name(k), v.name, cr, ci);
+    }
+  };
+  for (std::size_t i = 0; i < cx.size(); ++i) {
+    expect(cx[i], cy[i], zx[i], zy[i]);
+    int rit = 0;
+    mandel::last_state<float>(cx[i], cy[i], p.max_iters, &rit);
+    if (its[i] != static_cast<std::uint32_t>(rit) && failures++ < 5)
+      std::fprintf(stderr, "%s/%s f32: c=(%.9g, %.9g) ran %u, expected %d\n",
+                   mandel::kernel_name(k), v.name, cx[i], cy[i], its[i], rit);
+  }
+  for (std::size_t i = 0; i < icx.size(); ++i)
+    expect(icx[i], icy[i], izx[i], izy[i]);
+  return failures;
+}
+
+} // namespace
+
+int main() {
+  const View views[] = {
+      {"default", view(-0.75, 0.0, 0.045, 200)},
+      {"seahorse", view(-0.745, 0.113, 0.0001, 1000)},
+      {"one-iter", view(-0.75, 0.0, 0.045, 1)},
+      {"exterior", view(1.5, 1.5, 0.01, 50)},
+      {"minibrot", view(-1.7687, 0.0017, 0.00002, 20000)},
+  };
+  int failures = 0;
+  for (mandel::Kernel k : {mandel::Kernel::scalar, mandel::Kernel::avx2,
+                           mandel::Kernel::avx512}) {
+    if (!mandel::kernel_supported(k)) {
+      std::printf("skip %s (not supported on this CPU)\n",
+                  mandel::kernel_name(k));
+      continue;
+    }
+    const char *name = mandel::kernel_name(k);
+    for (const View &v : views)
+      failures += check(name, mandel::kernel_fn(k), v, -1.0) +
+                  check(name, mandel::kernel_fn(k), v, 0.0) +
+                  check_interior(k, v) + check_f32(k, v);
+    std::printf("ok   %s\n", name);
+  }
+  for (int unroll : {2, 4, 8, 16}) {
+    char name[16];
+    std::snprintf(name, sizeof name, "unroll%d", unroll);
+    for (const View &v : views)
+      failures += check(name, mandel::unrolled_kernel_fn(unroll), v, -1.0) +
+                  check(name, mandel::unrolled_kernel_fn(unroll), v, 0.0);
+    std::printf("ok   %s\n", name);
+  }
+  if (failures != 0) {
+    std::fprintf(stderr, "%d mismatching pixels\n", failures);
+    return 1;
+  }
+  return 0;
+}
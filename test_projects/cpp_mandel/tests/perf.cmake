@@ -0,0 +1,86 @@
+# cmake-format: off
+# ------------------------------------------------------------------------------
+# tests/perf.cmake
+#
+# CTest driver for mandel_cli --perf. Hardware counters are missing on most
+# CI machines (virtual machines, macOS, Windows), so this checks both
+# outcomes: the run succeeds with an unchanged output, and the report
+# either counts events (non-zero cycles over the whole run) or says why
+# not and leaves every counter null. --perf without --stats is rejected.
+#
+# Variables (passed by add_test(... COMMAND cmake -D... -P perf.cmake)):
+#   CLI    : full path to the mandel_cli executable              (REQUIRED)
+#   DIR    : scratch directory for the outputs                   (REQUIRED)
+#
+# Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
+# ------------------------------------------------------------------------------
+# cmake-format: on
+
+foreach(var IN ITEMS CLI DIR)
+  if(NOT DEFINED ${var} OR "${${var}}" STREQUAL "")
+    message(FATAL_ERROR "perf.cmake: ${var} not provided.")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE "${DIR}")
+file(MAKE_DIRECTORY "${DIR}")
+
+function(run)
+  execute_process(
+    COMMAND "${CLI}" ${ARGN}
+    RESULT_VARIABLE rv
+    ERROR_VARIABLE err)
+  if(NOT rv EQUAL 0)
+    message(FATAL_ERROR "mandel_cli ${ARGN} failed (${rv}):\n${err}")
+  endif()
+endfunction()
+
+set(view --width 40 --height 30 --max-iters 100 --threads 2)
+run(${view} --out "${DIR}/ref.csv")
+run(${view} --out "${DIR}/out.csv" --stats "${DIR}/stats.json" --perf)
+file(SHA256 "${DIR}/ref.csv" want)
+file(SHA256 "${DIR}/out.csv" got)
+if(NOT want STREQUAL got)
+  message(FATAL_ERROR "--perf changed the output")
+endif()
+
+file(READ "${DIR}/stats.json" json)
+string(JSON available GET "${json}" perf available)
+string(JSON cycles_type TYPE "${json}" total counters cycles)
+if(available)
+  string(JSON events LENGTH "${json}" perf events)
+  if(events EQUAL 0)
+    message(FATAL_ERROR "perf: available but no events listed")
+  endif()
+  if(cycles_type STREQUAL "NUMBER")
+    string(JSON cycles GET "${json}" total counters cycles)
+    if(NOT cycles GREATER 0)
+      message(FATAL_ERROR "perf: no cycles counted over the run")
+    endif()
+  endif()
+else()
+  string(JSON reason GET "${json}" perf reason)
+  if(reason STREQUAL "")
+    message(FATAL_ERROR "perf: unavailable without a reason")
+  endif()
+  foreach(phase IN ITEMS read compute write cache)
+    string(JSON type TYPE "${json}" phases ${phase} counters instructions)
+    if(NOT type STREQUAL "NULL")
+      message(FATAL_ERROR "perf: ${phase} instructions not null: ${type}")
+    endif()
+  endforeach()
+  if(NOT cycles_type STREQUAL "NULL")
+    message(FATAL_ERROR "perf: total cycles not null: ${cycles_type}")
+  endif()
+  message(STATUS "No hardware counters here: ${reason}")
+endif()
+
+execute_process(
+  COMMAND "${CLI}" ${view} --out "${DIR}/x.csv" --perf
+  RESULT_VARIABLE rv
+  OUTPUT_QUIET ERROR_QUIET)
+if(rv EQUAL 0)
+  message(FATAL_ERROR "--perf without --stats was accepted")
+endif()
+
+message(STATUS "Perf OK: ${DIR}")
@@ -0,0 +1,151 @@
+// Checks the double-double parser, and that Engine::perturbation agrees
+// with brute-force double-double iteration of every pixel: at a deep zoom
+// where double coordinates have no resolution left, and around a center
+// whose own orbit escapes early, which forces rebasing onto the reference;
+// and that the series approximation skips iterations at the deep zoom
+// without changing the result beyond that agreement.
+#include "mandel/perturbation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+int check_parse() {
+  int failures = 0;
+  auto expect = [&](const char *text, double hi, double tol) {
+    const mandel::DoubleDouble v = mandel::parse_double_double(text);
+    if (v.hi != hi || std::fabs(v.lo) > tol) {
+      std::fprintf(stderr, "parse(\"%s\") = %.17g + %.17g\n", text, v.hi,
+                   v.lo);
+      ++failures;
+    }
+  };
+  expect("2", 2.0, 0.0);
+  expect(" -1.25e-3 ", -0.00125, 1.1e-19); // lo: residual below ulp/2
+  expect(".5", 0.5, 0.0);
+  // 0.1 is not a double: lo must carry the residual 0.1 - fl(0.1).
+  const mandel::DoubleDouble tenth = mandel::parse_double_double("0.1");
+  const mandel::DoubleDouble one = tenth * mandel::DoubleDouble{10.0, 0.0};
+  if (tenth.lo == 0.0 || one.hi != 1.0 || std::fabs(one.lo) > 1e-31) {
+    std::fprintf(stderr, "0.1 * 10 = %.17g + %.17g\n", one.hi, one.lo);
+    ++failures;
+  }
+  for (const char *bad : {"", "-", "1e", "1.2.3", "abc", "1x"}) {
+    try {
+      mandel::parse_double_double(bad);
+      std::fprintf(stderr, "parse(\"%s\") did not throw\n", bad);
+      ++failures;
+    } catch (const std::runtime_error &) {
+    }
+  }
+  return failures;
+}
+
+// Final z of c = center + offset, iterated entirely in double-double.
+std::pair<double, double> brute_force(mandel::DoubleDouble cx,
+                                      mandel::DoubleDouble cy, int max_iters) {
+  mandel::DoubleDouble zr, zi;
+  const mandel::DoubleDouble two{2.0, 0.0};
+  for (int it = 0; it < max_iters && zr.hi * zr.hi + zi.hi * zi.hi <= 4.0;
+       ++it) {
+    const mandel::DoubleDouble zr2 = zr * zr - zi * zi + cx;
+    zi = two * zr * zi + cy;
+    zr = zr2;
+  }
+  return {zr.hi, zi.hi};
+}
+
+// Orbits are chaotic, so rounding differences between the two methods grow
+// with depth and iteration count (both drift from the exact orbit by the
+// same order). Demand agreement on membership for nearly every pixel, and a
+// median final-z difference no larger than `ztol`.
+int check_view(const char *name, const mandel::Params &p, double ztol) {
+  std::vector<mandel::PixelResult> out;
+  mandel::compute_grid(p, out);
+  const auto [cx, cy] = mandel::view_center(p);
+  int inside = 0, mismatches = 0;
+  std::set<std::pair<double, double>> distinct;
+  std::vector<double> dz;
+  for (const auto &r : out) {
+    distinct.emplace(r.x, r.y);
+    const auto [dx, dy] = mandel::pixel_offset(p, r.px, r.py);
+    const auto [bx, by] = brute_force(cx + mandel::DoubleDouble{dx, 0.0},
+                                      cy + mandel::DoubleDouble{dy, 0.0},
+                                      p.max_iters);
+    const bool in = bx * bx + by * by <= 4.0;
+    inside += in;
+    mismatches += in != (r.x * r.x + r.y * r.y <= 4.0);
+    dz.push_back(std::hypot(bx - r.x, by - r.y));
+  }
+  std::sort(dz.begin(), dz.end());
+  const double median = dz[dz.size() / 2];
+  const double frac = static_cast<double>(mismatches) / out.size();
+  std::printf("%-10s %zu pixels, %zu distinct, %d inside, %d membership "
+              "mismatches (%.2f%%), median |dz| %.1e\n",
+              name, out.size(), distinct.size(), inside, mismatches,
+              100.0 * frac, median);
+  // A collapsed view (every pixel the same c) would agree trivially.
+  if (distinct.size() < out.size() / 2 || frac > 0.02 || median > ztol) {
+    std::fprintf(stderr, "%s: too many mismatches or a degenerate view\n",
+                 name);
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace
+
+int main() {
+  int failures = check_parse();
+
+  mandel::Params deep;
+  deep.engine = mandel::Engine::perturbation;
+  deep.width = 32;
+  deep.height = 24;
+  deep.center_x_text = "-0.743643887037158704752191506114774";
+  deep.center_y_text = "0.131825904205311970493132056385139";
+  deep.center_x = -0.743643887037158704752191506114774;
+  deep.center_y = 0.131825904205311970493132056385139;
+  deep.scale = 1e-24;
+  deep.max_iters = 20000;
+  failures += check_view("deep", deep, 1e-3);
+
+  // Same view with the series approximation, which must actually skip.
+  mandel::Params series = deep;
+  series.series_order = 8;
+  std::atomic<int> tiles{0}, skipping{0};
+  series.on_tile = [&](const mandel::TileReport &t) {
+    ++tiles;
+    skipping += t.series_skipped > 0;
+  };
+  failures += check_view("series", series, 1e-3);
+  std::printf("series     %d of %d tiles skipped iterations\n",
+              skipping.load(), tiles.load());
+  if (tiles == 0 || skipping != tiles) {
+    std::fprintf(stderr, "series: expected every tile to skip\n");
+    ++failures;
+  }
+
+  mandel::Params escaping; // center escapes after a few steps
+  escaping.engine = mandel::Engine::perturbation;
+  escaping.width = 64;
+  escaping.height = 48;
+  escaping.center_x = 0.3;
+  escaping.center_y = 0.6;
+  escaping.scale = 0.01;
+  escaping.max_iters = 500;
+  failures += check_view("rebasing", escaping, 1e-12);
+
+  if (failures != 0) {
+    std::fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,156 @@
+// Checks the precision backends: quad-double arithmetic and parsing, the
+// Precision::automatic choice, that dd and qd grids agree with each other
+// at a depth where double has no resolution left, and that f32 and f64
+// agree on membership at a preview scale.
+#include "mandel/kernels.hpp"
+#include "mandel/precision.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// |a - b| as a double, for values known to be close.
+double qd_diff(const mandel::QuadDouble &a, const mandel::QuadDouble &b) {
+  const mandel::QuadDouble d = a - b;
+  return std::fabs(d.x[0]);
+}
+
+int check_quad_double() {
+  int failures = 0;
+  auto expect = [&](const char *what, double err, double tol) {
+    if (!(err <= tol)) {
+      std::fprintf(stderr, "%s: error %g > %g\n", what, err, tol);
+      ++failures;
+    }
+  };
+  const mandel::QuadDouble one{{1.0, 0.0, 0.0, 0.0}};
+  const mandel::QuadDouble three{{3.0, 0.0, 0.0, 0.0}};
+  const mandel::QuadDouble ten{{10.0, 0.0, 0.0, 0.0}};
+  const mandel::QuadDouble third = one / three;
+  expect("(1/3)*3", qd_diff(third * three, one), 1e-63);
+  expect("0.1*10", qd_diff(mandel::parse_quad_double("0.1") * ten, one),
+         1e-63);
+  // Digits far beyond double-double survive parsing.
+  const mandel::QuadDouble a = mandel::parse_quad_double(
+      "1.00000000000000000000000000000000000000000000000001");
+  expect("1 + 1e-50", std::fabs(qd_diff(a, one) - 1e-50), 1e-62);
+  const mandel::QuadDouble b = mandel::parse_quad_double("-2.5e-3");
+  expect("-2.5e-3", std::fabs(b.x[0] + 0.0025), 0.0);
+  // (a + b) - a == b.
+  expect("(a+b)-a", qd_diff((a + b) - a, b), 1e-63);
+  try {
+    mandel::parse_quad_double("1.2.3");
+    std::fprintf(stderr, "parse_quad_double(\"1.2.3\") did not throw\n");
+    ++failures;
+  } catch (const std::runtime_error &) {
+  }
+  return failures;
+}
+
+int check_auto() {
+  int failures = 0;
+  auto expect = [&](double scale, mandel::Precision want) {
+    mandel::Params p;
+    p.precision = mandel::Precision::automatic;
+    p.scale = scale;
+    const mandel::Precision got = mandel::resolve_precision(p);
+    if (got != want) {
+      std::fprintf(stderr, "auto at scale %g: %s, expected %s\n", scale,
+                   mandel::precision_name(got), mandel::precision_name(want));
+      ++failures;
+    }
+  };
+  expect(0.003, mandel::Precision::f32);
+  expect(1e-6, mandel::Precision::f64);
+  expect(1e-20, mandel::Precision::dd);
+  expect(1e-40, mandel::Precision::qd);
+  mandel::Params p;
+  p.scale = 1e-70;
+  p.precision = mandel::Precision::automatic;
+  try {
+    mandel::resolve_precision(p);
+    std::fprintf(stderr, "auto at scale 1e-70 did not throw\n");
+    ++failures;
+  } catch (const std::runtime_error &) {
+  }
+  p.scale = 1e-20;
+  p.engine = mandel::Engine::subdivide;
+  if (mandel::resolve_precision(p) != mandel::Precision::f64) {
+    std::fprintf(stderr, "auto with subdivide did not resolve to double\n");
+    ++failures;
+  }
+  return failures;
+}
+
+// Membership must agree for nearly every pixel, and the median final-z
+// difference stay within ztol (orbits are chaotic, so individual pixels
+// may drift further apart).
+int compare(const char *name, const mandel::Params &a,
+            const mandel::Params &b, double ztol) {
+  std::vector<mandel::PixelResult> ra, rb;
+  mandel::compute_grid(a, ra);
+  mandel::compute_grid(b, rb);
+  std::set<std::pair<double, double>> distinct;
+  std::vector<double> dz;
+  int mismatches = 0;
+  for (std::size_t i = 0; i < ra.size(); ++i) {
+    distinct.emplace(ra[i].x, ra[i].y);
+    const bool in_a = ra[i].x * ra[i].x + ra[i].y * ra[i].y <= 4.0;
+    const bool in_b = rb[i].x * rb[i].x + rb[i].y * rb[i].y <= 4.0;
+    mismatches += in_a != in_b;
+    dz.push_back(std::hypot(ra[i].x - rb[i].x, ra[i].y - rb[i].y));
+  }
+  std::sort(dz.begin(), dz.end());
+  const double median = dz[dz.size() / 2];
+  const double frac = static_cast<double>(mismatches) / ra.size();
+  std::printf("%-8s %zu pixels, %zu distinct, %d membership mismatches, "
+              "median |dz| %.1e\n",
+              name, ra.size(), distinct.size(), mismatches, median);
+  if (distinct.size() < ra.size() / 2 || frac > 0.02 || median > ztol) {
+    std::fprintf(stderr, "%s: precisions disagree\n", name);
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace
+
+int main() {
+  int failures = check_quad_double() + check_auto();
+
+  // Spacing 1e-24 is far below double resolution near c = -0.74.
+  mandel::Params dd;
+  dd.width = 24;
+  dd.height = 16;
+  dd.center_x_text = "-0.743643887037158704752191506114774";
+  dd.center_y_text = "0.131825904205311970493132056385139";
+  dd.center_x = -0.743643887037158704752191506114774;
+  dd.center_y = 0.131825904205311970493132056385139;
+  dd.scale = 1e-24;
+  dd.max_iters = 20000;
+  dd.precision = mandel::Precision::dd;
+  mandel::Params qd = dd;
+  qd.precision = mandel::Precision::qd;
+  failures += compare("dd/qd", dd, qd, 1e-3);
+
+  mandel::Params f64;
+  f64.width = 96;
+  f64.height = 64;
+  f64.scale = 0.04;
+  f64.max_iters = 100;
+  mandel::Params f32 = f64;
+  f32.precision = mandel::Precision::f32;
+  failures += compare("f32/f64", f32, f64, 1e-4);
+
+  if (failures != 0) {
+    std::fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  return 0;
+}
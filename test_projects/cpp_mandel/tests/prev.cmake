@@ -0,0 +1,68 @@
+# cmake-format: off
+# ------------------------------------------------------------------------------
+# tests/prev.cmake
+#
+# CTest driver for mandel_cli --prev. Renders a raw view, then pans it by a
+# whole number of pixels with and without --prev, and checks that both runs
+# write identical files: for x/y, for extra channels, and for a previous
+# grid whose settings rule out reuse. A --prev that is missing or not raw
+# must fail with a --prev error.
+#
+# Variables (passed by add_test(... COMMAND cmake -D... -P prev.cmake)):
+#   CLI    : full path to the mandel_cli executable              (REQUIRED)
+#   DIR    : scratch directory for the outputs                   (REQUIRED)
+#
+# Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
+# ------------------------------------------------------------------------------
+# cmake-format: on
+
+foreach(var IN ITEMS CLI DIR)
+  if(NOT DEFINED ${var} OR "${${var}}" STREQUAL "")
+    message(FATAL_ERROR "prev.cmake: ${var} not provided.")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE "${DIR}")
+file(MAKE_DIRECTORY "${DIR}")
+
+function(run)
+  execute_process(
+    COMMAND "${CLI}" ${ARGN}
+    RESULT_VARIABLE rv
+    ERROR_VARIABLE err)
+  if(NOT rv EQUAL 0)
+    message(FATAL_ERROR "mandel_cli ${ARGN} failed (${rv}):\n${err}")
+  endif()
+endfunction()
+
+# name: output stem; prev_args: options of the earlier view; args: the pan.
+function(check name prev_args args)
+  run(${prev_args} --format raw --out "${DIR}/${name}.prev.raw")
+  run(${args} --out "${DIR}/${name}.ref.csv")
+  run(${args} --prev "${DIR}/${name}.prev.raw" --out "${DIR}/${name}.csv")
+  file(SHA256 "${DIR}/${name}.ref.csv" want)
+  file(SHA256 "${DIR}/${name}.csv" got)
+  if(NOT want STREQUAL got)
+    message(FATAL_ERROR "${name}: --prev changed the output")
+  endif()
+endfunction()
+
+set(view --width 97 --height 61 --max-iters 300 --scale 0.003)
+check(pan "${view};--center-x;-0.75" "${view};--center-x;-0.72")
+set(ch --channels it,escaped,smooth,x,y)
+check(channels "${view};${ch};--center-y;0.1"
+      "${view};${ch};--center-y;0.07;--engine;subdivide")
+check(mismatch "${view};--max-iters;200" "${view};--center-x;-0.72")
+
+# A missing or non-raw --prev is reported as such, not as a config error.
+foreach(bad IN ITEMS missing.raw mismatch.ref.csv)
+  execute_process(
+    COMMAND "${CLI}" ${view} --prev "${DIR}/${bad}" --out "${DIR}/bad.csv"
+    RESULT_VARIABLE rv
+    ERROR_VARIABLE err)
+  if(rv EQUAL 0 OR NOT err MATCHES "--prev needs raw output with a sidecar")
+    message(FATAL_ERROR "--prev ${bad}: expected a --prev error, got:\n${err}")
+  endif()
+endforeach()
+
+message(STATUS "Prev OK: ${DIR}")
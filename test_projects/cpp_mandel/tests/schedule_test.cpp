@@ -0,0 +1,164 @@
+// Checks that every Schedule gives the same output as Schedule::steal, for
+// each engine, through compute_grid(), compute_grid_streaming() (several
+// ring sizes) and compute_grid_incremental(), with several thread counts.
+// The cost schedule splits and reorders tiles; none of that may show.
+// Also checks that the rows schedule's pinned tasks are never stolen.
+#include "mandel/core.hpp"
+#include "mandel/kernels.hpp"
+#include "mandel/parallel.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+bool same(const mandel::GridResult &a, const mandel::GridResult &b) {
+  const std::size_t n = a.size();
+  return b.size() == n &&
+         std::memcmp(a.x(), b.x(), n * sizeof(double)) == 0 &&
+         std::memcmp(a.y(), b.y(), n * sizeof(double)) == 0 &&
+         std::memcmp(a.iterations(), b.iterations(),
+                     n * sizeof(std::uint32_t)) == 0;
+}
+
+mandel::GridResult streamed(const mandel::Params &p, mandel::ThreadPool &pool,
+                            int ring) {
+  mandel::GridResult g;
+  g.resize(p.width, p.height, p.channels);
+  mandel::compute_grid_streaming(
+      p,
+      [&](const mandel::GridView &rows) {
+        const std::size_t at = static_cast<std::size_t>(rows.y0) * p.width;
+        std::memcpy(g.x() + at, rows.x, rows.size() * sizeof(double));
+        std::memcpy(g.y() + at, rows.y, rows.size() * sizeof(double));
+        std::memcpy(g.iterations() + at, rows.iterations,
+                    rows.size() * sizeof(std::uint32_t));
+      },
+      pool, ring);
+  return g;
+}
+
+int check(mandel::Params p, const char *what) {
+  p.channels = {mandel::Channel::x, mandel::Channel::y,
+                mandel::Channel::iterations};
+  mandel::GridResult expected;
+  mandel::compute_grid(p, expected);
+  int failures = 0;
+  for (mandel::Schedule s : {mandel::Schedule::rows, mandel::Schedule::steal,
+                             mandel::Schedule::cost}) {
+    p.schedule = s;
+    for (int threads : {1, 3, 8}) {
+      mandel::ThreadPool pool(threads);
+      mandel::GridResult got;
+      mandel::compute_grid(p, got, pool);
+      bool ok = same(got, expected);
+      for (int ring : {0, 1, 5})
+        ok = ok && same(streamed(p, pool, ring), expected);
+      if (!ok) {
+        std::fprintf(stderr, "%s: schedule %s, %d threads differs\n", what,
+                     mandel::schedule_name(s), threads);
+        ++failures;
+      }
+    }
+  }
+  return failures;
+}
+
+// A pan by whole pixels: the strip left to compute goes through the
+// schedule too.
+int check_incremental() {
+  mandel::Params prev;
+  prev.width = 90;
+  prev.height = 61;
+  prev.max_iters = 300;
+  prev.channels = {mandel::Channel::x, mandel::Channel::y,
+                   mandel::Channel::iterations};
+  mandel::GridResult before;
+  mandel::compute_grid(prev, before);
+  mandel::Params p = prev;
+  p.center_x += 17 * p.scale;
+  mandel::GridResult expected;
+  mandel::compute_grid(p, expected);
+  int failures = 0;
+  for (mandel::Schedule s : {mandel::Schedule::rows, mandel::Schedule::cost}) {
+    p.schedule = s;
+    mandel::ThreadPool pool(3);
+    mandel::GridResult got;
+    mandel::compute_grid_incremental(prev, before, p, got, pool);
+    if (!same(got, expected)) {
+      std::fprintf(stderr, "incremental: schedule %s differs\n",
+                   mandel::schedule_name(s));
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+// Schedule::rows is static: a pinned task runs on its own participant even
+// when the others are idle and could steal it.
+int check_pinned() {
+  mandel::ThreadPool pool(4);
+  int failures = 0;
+  for (int round = 0; round < 50; ++round) {
+    std::vector<int> ran(8, -1);
+    pool.parallel_for(
+        ran.size(), [&](std::size_t i, int worker) { ran[i] = worker; },
+        mandel::ThreadPool::Deal::pinned);
+    for (std::size_t i = 0; i < ran.size(); ++i)
+      if (ran[i] != static_cast<int>(i / 2)) {
+        std::fprintf(stderr, "pinned task %zu ran on participant %d\n", i,
+                     ran[i]);
+        ++failures;
+      }
+  }
+  return failures;
+}
+
+} // namespace
+
+int main() {
+  mandel::Params p;
+  p.width = 131; // partial tiles in both directions
+  p.height = 75;
+  p.max_iters = 500;
+  p.center_y = 0.05; // no mirrored rows
+  int failures = check(p, "grid");
+  p.center_y = 0.0; // mirrored rows
+  failures += check(p, "grid, mirrored");
+  // Interior samples charged by the work done rather than by max_iters.
+  p.interior = mandel::Interior::attractor;
+  failures += check(p, "grid, attractor");
+  p.interior = mandel::Interior::exact;
+  p.cycle_tol = 0.0;
+  p.max_iters = 2500; // cardioid/bulb points take cycle detection too
+  failures += check(p, "grid, cycle detection");
+  p.cycle_tol = -1.0;
+  p.max_iters = 500;
+  p.precision = mandel::Precision::f32;
+  failures += check(p, "grid, float");
+  p.precision = mandel::Precision::f64;
+  p.engine = mandel::Engine::subdivide;
+  failures += check(p, "subdivide");
+  p.fill = mandel::Fill::approximate;
+  failures += check(p, "subdivide, approximate");
+  p = mandel::Params{};
+  p.width = 97;
+  p.height = 66;
+  p.max_iters = 2000;
+  p.engine = mandel::Engine::perturbation;
+  p.center_x_text = "-0.743643887037151";
+  p.center_y_text = "0.131825904205330";
+  p.scale = 1e-12;
+  p.series_order = 4;
+  failures += check(p, "perturbation");
+  failures += check_incremental();
+  failures += check_pinned();
+  if (failures != 0) {
+    std::fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  std::printf("ok\n");
+  return 0;
+}
@@ -15,6 +15,9 @@
 #   HEIGHT : height in pixels; tiny for speed (default: 6)       (OPTIONAL)
 #   MAXIT  : max iterations; also tiny (default: 10)             (OPTIONAL)
 #   CONFIG : optional path to a config file (.json/.toml/.yaml/.yml/.xml)
+#   FORMAT : csv (default), npy or raw. For npy the file must start with the
+#            NumPy magic and hold a 64-byte aligned header plus 2*W*H float64s;
+#            for raw it must hold exactly 2*W*H float64s next to OUT.json.
 #
 # Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
 # ------------------------------------------------------------------------------
@@ -43,6 +46,9 @@ endif()
 if(NOT DEFINED MAXIT)
   set(MAXIT 10)
 endif()
+if(NOT DEFINED FORMAT)
+  set(FORMAT csv)
+endif()
 
 # ---- build the command line --------------------------------------------------
 # Always pass width/height/max-iters/out to keep the run tiny and fast. If
@@ -60,6 +66,8 @@ list(
   "${HEIGHT}"
   --max-iters
   "${MAXIT}"
+  --format
+  "${FORMAT}"
   --out
   "${OUT}")
 
@@ -79,9 +87,44 @@ if(NOT run_rv EQUAL 0)
       "STDERR  :\n${run_err}\n")
 endif()
 
-# ---- validate CSV exists -----------------------------------------------------
+# ---- validate output exists --------------------------------------------------
 if(NOT EXISTS "${OUT}")
-  message(FATAL_ERROR "CSV not produced at expected path: ${OUT}")
+  message(FATAL_ERROR "Output not produced at expected path: ${OUT}")
+endif()
+
+# ---- binary formats: check layout by size ------------------------------------
+if(NOT FORMAT STREQUAL "csv")
+  file(SIZE "${OUT}" out_size)
+  math(EXPR payload "16 * ${WIDTH} * ${HEIGHT}")
+  set(header_size 0)
+  if(FORMAT STREQUAL "npy")
+    # Magic "\x93NUMPY", version 1.0, little-endian uint16 header length.
+    file(READ "${OUT}" head LIMIT 10 HEX)
+    string(SUBSTRING "${head}" 0 16 magic)
+    if(NOT magic STREQUAL "934e554d50590100")
+      message(FATAL_ERROR "Bad npy magic/version (${magic}): ${OUT}")
+    endif()
+    string(SUBSTRING "${head}" 16 2 len_lo)
+    string(SUBSTRING "${head}" 18 2 len_hi)
+    math(EXPR header_size "10 + 0x${len_lo} + 256 * 0x${len_hi}")
+    math(EXPR misalign "${header_size} % 64")
+    if(NOT misalign EQUAL 0)
+      message(FATAL_ERROR "npy data not 64-byte aligned (${header_size})")
+    endif()
+  elseif(FORMAT STREQUAL "raw")
+    if(NOT EXISTS "${OUT}.json")
+      message(FATAL_ERROR "raw sidecar not produced: ${OUT}.json")
+    endif()
+  endif()
+  math(EXPR expected "${header_size} + ${payload}")
+  if(NOT out_size EQUAL expected)
+    message(
+      FATAL_ERROR
+        "${FORMAT} size mismatch: expected ${expected} bytes, got ${out_size}\n"
+        "File: ${OUT}")
+  endif()
+  message(STATUS "Smoke OK: ${OUT}  (${FORMAT}, ${out_size} bytes)")
+  return()
 endif()
 
 # ---- read file lines (portable) ----------------------------------------------
@@ -0,0 +1,70 @@
+# cmake-format: off
+# ------------------------------------------------------------------------------
+# tests/stats.cmake
+#
+# CTest driver for mandel_cli --stats. Checks that the report is valid JSON
+# with the expected totals (grids, pixels, iterations, bytes, threads) and
+# every phase, and that asking for it leaves the output unchanged.
+#
+# Variables (passed by add_test(... COMMAND cmake -D... -P stats.cmake)):
+#   CLI    : full path to the mandel_cli executable              (REQUIRED)
+#   DIR    : scratch directory for the outputs                   (REQUIRED)
+#
+# Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
+# ------------------------------------------------------------------------------
+# cmake-format: on
+
+foreach(var IN ITEMS CLI DIR)
+  if(NOT DEFINED ${var} OR "${${var}}" STREQUAL "")
+    message(FATAL_ERROR "stats.cmake: ${var} not provided.")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE "${DIR}")
+file(MAKE_DIRECTORY "${DIR}")
+
+function(run)
+  execute_process(
+    COMMAND "${CLI}" ${ARGN}
+    RESULT_VARIABLE rv
+    ERROR_VARIABLE err)
+  if(NOT rv EQUAL 0)
+    message(FATAL_ERROR "mandel_cli ${ARGN} failed (${rv}):\n${err}")
+  endif()
+endfunction()
+
+function(expect json want)
+  string(JSON got GET "${json}" ${ARGN})
+  if(NOT got STREQUAL want)
+    message(FATAL_ERROR "stats ${ARGN}: got ${got}, want ${want}")
+  endif()
+endfunction()
+
+set(view --width 40 --height 30 --max-iters 100 --threads 2 --format raw)
+run(${view} --out "${DIR}/ref.raw")
+run(${view} --out "${DIR}/out.raw" --stats "${DIR}/stats.json")
+file(SHA256 "${DIR}/ref.raw" want)
+file(SHA256 "${DIR}/out.raw" got)
+if(NOT want STREQUAL got)
+  message(FATAL_ERROR "--stats changed the output")
+endif()
+
+file(READ "${DIR}/stats.json" json)
+expect("${json}" 1 grids)
+expect("${json}" 1200 pixels)
+expect("${json}" 2 threads)
+file(SIZE "${DIR}/out.raw" data)
+file(SIZE "${DIR}/out.raw.json" side)
+math(EXPR bytes "${data} + ${side}")
+expect("${json}" ${bytes} bytes_written)
+string(JSON iterations GET "${json}" iterations)
+if(NOT iterations GREATER 1200)
+  message(FATAL_ERROR "stats: implausible iteration count ${iterations}")
+endif()
+foreach(phase IN ITEMS config read compute write cache)
+  string(JSON wall GET "${json}" phases ${phase} wall_s)
+  string(JSON cpu GET "${json}" phases ${phase} cpu_s)
+endforeach()
+string(JSON rss GET "${json}" peak_rss_bytes)
+
+message(STATUS "Stats OK: ${DIR}")
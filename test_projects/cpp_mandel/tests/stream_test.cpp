@@ -0,0 +1,187 @@
+// Checks that compute_grid_streaming() delivers exactly the rows of
+// compute_grid(), in order, for several thread counts and ring sizes (the
+// extra output channels included, through mirrored rows), that
+// compute_frames_streaming() does the same for each frame of a sequence,
+// and that an exception thrown by the sink reaches the caller.
+#include "mandel/core.hpp"
+#include "mandel/parallel.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+bool same(const mandel::PixelResult &a, const mandel::PixelResult &b) {
+  return a.px == b.px && a.py == b.py &&
+         std::memcmp(&a.x, &b.x, sizeof a.x) == 0 &&
+         std::memcmp(&a.y, &b.y, sizeof a.y) == 0;
+}
+
+int check(const mandel::Params &p, int threads, int ring) {
+  std::vector<mandel::PixelResult> expected;
+  mandel::compute_grid(p, expected);
+
+  mandel::ThreadPool pool(threads);
+  std::vector<mandel::PixelResult> got;
+  int next_row = 0;
+  int failures = 0;
+  mandel::compute_grid_streaming(
+      p,
+      [&](const mandel::GridView &rows) {
+        if (rows.y0 != next_row && failures++ < 5)
+          std::fprintf(stderr, "threads %d ring %d: got rows at %d, want %d\n",
+                       threads, ring, rows.y0, next_row);
+        next_row = rows.y0 + rows.rows;
+        got.insert(got.end(), rows.begin(), rows.end());
+      },
+      pool, ring);
+
+  if (got.size() != expected.size()) {
+    std::fprintf(stderr, "threads %d ring %d: %zu results, want %zu\n",
+                 threads, ring, got.size(), expected.size());
+    return failures + 1;
+  }
+  for (std::size_t i = 0; i < got.size(); ++i) {
+    if (!same(got[i], expected[i]) && failures++ < 5)
+      std::fprintf(stderr, "threads %d ring %d: pixel %zu differs\n", threads,
+                   ring, i);
+  }
+  return failures;
+}
+
+// Iterations, escaped and smooth of every row, as streamed.
+int check_channels(const mandel::Params &p, int threads) {
+  mandel::GridResult expected;
+  mandel::compute_grid(p, expected);
+  std::vector<std::uint32_t> it;
+  std::vector<std::uint8_t> escaped;
+  std::vector<double> smooth;
+  mandel::ThreadPool pool(threads);
+  mandel::compute_grid_streaming(
+      p,
+      [&](const mandel::GridView &rows) {
+        it.insert(it.end(), rows.iterations, rows.iterations + rows.size());
+        escaped.insert(escaped.end(), rows.escaped,
+                       rows.escaped + rows.size());
+        smooth.insert(smooth.end(), rows.smooth, rows.smooth + rows.size());
+      },
+      pool);
+  const std::size_t n = expected.size();
+  if (it.size() != n || escaped.size() != n || smooth.size() != n ||
+      std::memcmp(it.data(), expected.iterations(), n * sizeof it[0]) != 0 ||
+      std::memcmp(escaped.data(), expected.escaped(), n) != 0 ||
+      std::memcmp(smooth.data(), expected.smooth(), n * sizeof smooth[0]) !=
+          0) {
+    std::fprintf(stderr, "threads %d: streamed channels differ\n", threads);
+    return 1;
+  }
+  return 0;
+}
+
+// A zoom sequence with mirrored rows, and frames of different heights
+// sharing the ring.
+int check_frames(int threads, int ring) {
+  std::vector<mandel::Params> frames;
+  for (int k = 0; k < 4; ++k) {
+    mandel::Params p;
+    p.width = 70;
+    p.height = 37 + 11 * k;
+    p.center_y = 0.0;
+    p.scale = 0.01 / (1 << k);
+    p.max_iters = 200;
+    p.channels = {mandel::Channel::x, mandel::Channel::y,
+                  mandel::Channel::iterations};
+    frames.push_back(p);
+  }
+  std::vector<std::vector<mandel::PixelResult>> got(frames.size());
+  std::vector<std::vector<std::uint32_t>> it(frames.size());
+  std::size_t next_frame = 0;
+  int next_row = 0;
+  int failures = 0;
+  mandel::ThreadPool pool(threads);
+  mandel::compute_frames_streaming(
+      frames,
+      [&](std::size_t frame, const mandel::GridView &rows) {
+        if (frame != next_frame) {
+          if (next_frame + 1 != frame || next_row != frames[next_frame].height)
+            ++failures;
+          next_frame = frame;
+          next_row = 0;
+        }
+        if (rows.y0 != next_row)
+          ++failures;
+        next_row = rows.y0 + rows.rows;
+        got[frame].insert(got[frame].end(), rows.begin(), rows.end());
+        it[frame].insert(it[frame].end(), rows.iterations,
+                         rows.iterations + rows.size());
+      },
+      pool, ring);
+  if (failures != 0)
+    std::fprintf(stderr, "threads %d ring %d: frames out of order\n",
+                 threads, ring);
+  for (std::size_t k = 0; k < frames.size(); ++k) {
+    mandel::GridResult expected;
+    mandel::compute_grid(frames[k], expected);
+    bool ok = got[k].size() == expected.size() &&
+              std::memcmp(it[k].data(), expected.iterations(),
+                          expected.size() * sizeof it[k][0]) == 0;
+    for (std::size_t i = 0; ok && i < got[k].size(); ++i)
+      ok = same(got[k][i], expected[i]);
+    if (!ok) {
+      std::fprintf(stderr, "threads %d ring %d: frame %zu differs\n",
+                   threads, ring, k);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+int check_sink_error() {
+  mandel::Params p;
+  p.width = 40;
+  p.height = 50;
+  p.threads = 3;
+  try {
+    mandel::compute_grid_streaming(
+        p, [](const mandel::GridView &rows) {
+          if (rows.y0 > 0)
+            throw std::runtime_error("sink failed");
+        });
+  } catch (const std::runtime_error &) {
+    return 0;
+  }
+  std::fprintf(stderr, "sink exception was swallowed\n");
+  return 1;
+}
+
+} // namespace
+
+int main() {
+  mandel::Params p;
+  p.width = 131; // partial tiles in both directions
+  p.height = 75;
+  p.max_iters = 300;
+  int failures = 0;
+  for (int threads : {1, 3})
+    for (int ring : {0, 1, 2, 7, 100})
+      failures += check(p, threads, ring);
+  p.channels = {mandel::Channel::smooth, mandel::Channel::iterations,
+                mandel::Channel::escaped, mandel::Channel::x,
+                mandel::Channel::y};
+  p.center_y = 0.0; // mirrored rows
+  for (int threads : {1, 3})
+    failures += check_channels(p, threads);
+  for (int threads : {1, 3})
+    for (int ring : {0, 1, 3, 100})
+      failures += check_frames(threads, ring);
+  failures += check_sink_error();
+  if (failures != 0) {
+    std::fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  std::printf("ok\n");
+  return 0;
+}
@@ -0,0 +1,124 @@
+# cmake-format: off
+# ------------------------------------------------------------------------------
+# tests/trace.cmake
+#
+# CTest driver for mandel_cli --trace. Checks that the timeline is valid
+# Chrome Trace Event JSON in which the tile spans cover every computed
+# pixel once, the flush spans cover every row once, the writer's finish is
+# recorded once and the main thread is named, and that tracing leaves the
+# output unchanged. Both writer paths are covered: rows streamed band by
+# band, and a whole grid written at once after a --prev recompute.
+#
+# Variables (passed by add_test(... COMMAND cmake -D... -P trace.cmake)):
+#   CLI    : full path to the mandel_cli executable              (REQUIRED)
+#   DIR    : scratch directory for the outputs                   (REQUIRED)
+#
+# Any failure calls message(FATAL_ERROR ...) so the CTest test fails.
+# ------------------------------------------------------------------------------
+# cmake-format: on
+
+foreach(var IN ITEMS CLI DIR)
+  if(NOT DEFINED ${var} OR "${${var}}" STREQUAL "")
+    message(FATAL_ERROR "trace.cmake: ${var} not provided.")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE "${DIR}")
+file(MAKE_DIRECTORY "${DIR}")
+
+function(run)
+  execute_process(
+    COMMAND "${CLI}" ${ARGN}
+    RESULT_VARIABLE rv
+    ERROR_VARIABLE err)
+  if(NOT rv EQUAL 0)
+    message(FATAL_ERROR "mandel_cli ${ARGN} failed (${rv}):\n${err}")
+  endif()
+endfunction()
+
+# Tallies the spans of a trace into pixels (tile areas), rows (flushed),
+# finishes and main_named in the caller's scope.
+function(scan path)
+  file(READ "${path}" json)
+  string(JSON n LENGTH "${json}" traceEvents)
+  math(EXPR last "${n} - 1")
+  set(px 0)
+  set(rw 0)
+  set(fin 0)
+  set(named FALSE)
+  foreach(i RANGE ${last})
+    string(JSON name GET "${json}" traceEvents ${i} name)
+    string(JSON ph GET "${json}" traceEvents ${i} ph)
+    if(name STREQUAL "thread_name")
+      string(JSON thread GET "${json}" traceEvents ${i} args name)
+      if(thread STREQUAL "main")
+        set(named TRUE)
+      endif()
+      continue()
+    endif()
+    if(NOT ph STREQUAL "M")
+      string(JSON ts GET "${json}" traceEvents ${i} ts)
+      string(JSON dur GET "${json}" traceEvents ${i} dur)
+    endif()
+    if(name STREQUAL "tile")
+      string(JSON x0 GET "${json}" traceEvents ${i} args x0)
+      string(JSON y0 GET "${json}" traceEvents ${i} args y0)
+      string(JSON x1 GET "${json}" traceEvents ${i} args x1)
+      string(JSON y1 GET "${json}" traceEvents ${i} args y1)
+      math(EXPR px "${px} + (${x1} - ${x0}) * (${y1} - ${y0})")
+    elseif(name STREQUAL "flush")
+      string(JSON r GET "${json}" traceEvents ${i} args rows)
+      math(EXPR rw "${rw} + ${r}")
+    elseif(name STREQUAL "finish")
+      math(EXPR fin "${fin} + 1")
+    endif()
+  endforeach()
+  set(pixels ${px} PARENT_SCOPE)
+  set(rows ${rw} PARENT_SCOPE)
+  set(finishes ${fin} PARENT_SCOPE)
+  set(main_named ${named} PARENT_SCOPE)
+endfunction()
+
+function(expect what got want)
+  if(NOT got EQUAL want)
+    message(FATAL_ERROR "trace ${what}: got ${got}, want ${want}")
+  endif()
+endfunction()
+
+function(expect_same a b)
+  file(SHA256 "${a}" ha)
+  file(SHA256 "${b}" hb)
+  if(NOT ha STREQUAL hb)
+    message(FATAL_ERROR "--trace changed ${b}")
+  endif()
+endfunction()
+
+# ---- 1) streamed; no mirrored rows, so every pixel belongs to a tile ---------
+set(view --width 70 --height 30 --max-iters 100 --threads 3 --no-symmetry)
+run(${view} --out "${DIR}/ref.csv")
+run(${view} --out "${DIR}/out.csv" --trace "${DIR}/trace.json")
+expect_same("${DIR}/ref.csv" "${DIR}/out.csv")
+scan("${DIR}/trace.json")
+expect("streamed pixels" ${pixels} 2100)
+expect("streamed rows" ${rows} 30)
+expect("streamed finishes" ${finishes} 1)
+if(NOT main_named)
+  message(FATAL_ERROR "trace: no thread named main")
+endif()
+
+# ---- 2) --prev: a pan by 16 rows, written as one grid ------------------------
+run(${view} --format raw --out "${DIR}/prev.raw")
+set(pan ${view} --center-y -0.048 --format raw)
+run(${pan} --out "${DIR}/pan_ref.raw")
+run(${pan} --prev "${DIR}/prev.raw" --out "${DIR}/pan.raw" --trace
+    "${DIR}/prev_trace.json")
+expect_same("${DIR}/pan_ref.raw" "${DIR}/pan.raw")
+expect_same("${DIR}/pan_ref.raw.json" "${DIR}/pan.raw.json")
+scan("${DIR}/prev_trace.json")
+if(NOT pixels GREATER 0 OR NOT pixels LESS 2100)
+  message(FATAL_ERROR "trace --prev: tiles cover ${pixels} pixels")
+endif()
+expect("--prev rows" ${rows} 30)
+expect("--prev finishes" ${finishes} 1)
+
+message(STATUS "Trace OK: ${DIR}")